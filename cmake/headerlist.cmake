@@ -8,6 +8,8 @@ set(headers
 
 	src/hkx/hkclass.inl
 	src/hkx/linkedmanager.h
+	src/hkx/mappedfile.h
+	src/hkx/indexcache.h
 	src/hkx/hkxfile.h
 	src/hkx/hkutils.h
 
@@ -6,6 +6,8 @@ set(sources
 	src/extern/imgui_stdlib.cpp
 
 	src/hkx/linkedmanager.cpp
+	src/hkx/mappedfile.cpp
+	src/hkx/indexcache.cpp
 	src/hkx/hkxfile.cpp
 
 	src/ui/mainwindow.cpp
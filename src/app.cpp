@@ -205,6 +205,7 @@ void mainLoop()
         }
 
         // notify
+        flushNotifications();
         ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 5.f);
         ImGui::RenderNotifications(); // <-- Here we render all notifications
         ImGui::PopStyleVar(1);
@@ -224,6 +225,9 @@ void mainLoop()
 
 void exitApp()
 {
+    // closed normally, unsaved edits aren't to be recovered
+    Hkx::HkxFileManager::getSingleton()->discardJournals();
+
     spdlog::info("Terminating ImGui...");
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
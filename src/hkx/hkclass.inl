@@ -4,6 +4,7 @@
 #include <string>
 #include <array>
 #include <map>
+#include <tuple>
 
 #include <pugixml.hpp>
 
@@ -1567,6 +1568,73 @@ inline const std::map<std::string_view, const char*>& getClassDefaultMap()
     return map;
 }
 
+//////////////////////////    REFERENCE PARAMS
+// which params of a class can hold object references, as "param" or "param/nested param" paths
+struct ClassRefParams
+{
+    StringSet refs;    // pcdata is "null", "#0123" or a list of those
+    StringSet structs; // holds hkobjects that have reference params of their own
+};
+
+// arrays that are empty in the templates, with the template of one element
+// nullptr when the array itself is a list of references
+constexpr auto g_ref_array_params = std::to_array<std::tuple<std::string_view, std::string_view, const char*>>({
+    {"hkbStateMachine", "states", nullptr},
+    {"hkbStateMachineStateInfo", "listeners", nullptr},
+    {"hkbStateMachineTransitionInfoArray", "transitions", g_def_hkbStateMachine_TransitionInfo},
+    {"hkbBlenderGenerator", "children", nullptr},
+    {"BSBoneSwitchGenerator", "ChildrenA", nullptr},
+    {"hkbClipTriggerArray", "triggers", g_def_hkbClipTrigger},
+    {"hkbManualSelectorGenerator", "generators", nullptr},
+    {"hkbPoseMatchingGenerator", "children", nullptr},
+    {"hkbModifierList", "modifiers", nullptr},
+    {"hkbEventRangeDataArray", "eventData", g_def_hkbEventRangeData},
+    {"hkbStateMachineEventPropertyArray", "events", g_def_hkbEvent},
+    {"hkbVariableValueSet", "variantVariableValues", nullptr},
+    {"hkbFootIkControlsModifier", "legs", g_def_hkbFootIkControlsModifier_Leg},
+});
+
+// derived from the templates, classes without one aren't in here
+inline const StringMap<ClassRefParams>& getClassRefParamMap()
+{
+    static const auto map = [] {
+        StringMap<ClassRefParams> retval;
+
+        auto addParams = [](ClassRefParams& params, pugi::xml_node obj, const std::string& prefix, auto& self) -> void {
+            for (auto param : obj.children("hkparam"))
+            {
+                auto             path = prefix + param.attribute("name").as_string();
+                std::string_view text = param.text().as_string();
+                if (param.child("hkobject"))
+                    for (auto child : param.children("hkobject"))
+                        self(params, child, path + "/", self);
+                else if ((text == "null") || (text == "nullptr") || text.starts_with('#'))
+                    params.refs.insert(path);
+            }
+        };
+
+        for (auto& [hkclass, def] : getClassDefaultMap())
+            addParams(retval[std::string(hkclass)], getXmlTemplate(def), "", addParams);
+        for (auto obj : getXmlTemplate(g_def_hkx).child("hksection").children("hkobject"))
+            addParams(retval[obj.attribute("class").as_string()], obj, "", addParams);
+        for (auto& [hkclass, param, elem_def] : g_ref_array_params)
+        {
+            auto& params = retval[std::string(hkclass)];
+            if (elem_def)
+                addParams(params, getXmlTemplate(elem_def), std::string(param) + "/", addParams);
+            else
+                params.refs.insert(std::string(param));
+        }
+
+        for (auto& [hkclass, params] : retval)
+            for (std::string_view path : params.refs)
+                for (auto pos = path.find('/'); pos != path.npos; pos = path.find('/', pos + 1))
+                    params.structs.insert(std::string(path.substr(0, pos)));
+        return retval;
+    }();
+    return map;
+}
+
 //////////////////////////    CLASS OF CLASSES
 
 constexpr auto g_class_generators = std::to_array<std::string_view>(
@@ -1,9 +1,13 @@
 #include "hkxfile.h"
 #include "hkclass.inl"
+#include "indexcache.h"
 
+#include <chrono>
+#include <cstring>
 #include <memory>
 #include <execution>
 #include <filesystem>
+#include <fstream>
 
 #include <spdlog/spdlog.h>
 
@@ -11,8 +15,249 @@ namespace Haviour
 {
 namespace Hkx
 {
-void HkxFile::loadFile(std::string_view path)
+constexpr auto g_parse_flags = pugi::parse_default & (~pugi::parse_escapes);
+
+// preorder over everything under root, no virtual calls like xml_tree_walker
+template <typename Func>
+static void forEachNode(pugi::xml_node root, Func&& func)
+{
+    auto node = root.first_child();
+    while (node)
+    {
+        func(node);
+
+        if (node.first_child())
+            node = node.first_child();
+        else
+        {
+            while ((node != root) && !node.next_sibling())
+                node = node.parent();
+            node = (node == root) ? pugi::xml_node{} : node.next_sibling();
+        }
+    }
+}
+template <typename Func>
+static void forEachPcdata(pugi::xml_node root, Func&& func)
+{
+    forEachNode(root, [&](pugi::xml_node node) {
+        if (node.type() == pugi::node_pcdata)
+            func(node);
+    });
+}
+
+// calls func(pos, "#0123") for every object reference in text
+template <typename Func>
+static void forEachRef(std::string_view text, Func&& func)
+{
+    size_t pos = text.find('#');
+    while (pos != text.npos)
+    {
+        if ((!pos || (text[pos - 1] != '&')) && // in case html entity, fuck html entities
+            (pos + 1 < text.size()) &&
+            ((text[pos + 1] >= '0') && (text[pos + 1] <= '9'))) // #IND #INF etc.
+        {
+            auto next_break = pos + 1;
+            while ((next_break != text.size()) && (text[next_break] >= '0') && (text[next_break] <= '9'))
+                ++next_break;
+            func(pos, text.substr(pos, next_break - pos));
+            pos = next_break - 1;
+        }
+        pos = text.find('#', pos + 1);
+    }
+}
+
+// sorted refs with repeats -> each ref once + how many times it appears
+static void countRefs(std::vector<ObjId>& refs, std::vector<uint32_t>& counts)
+{
+    counts.clear();
+    size_t num_unique = 0;
+    for (auto ref_id : refs)
+        if (num_unique && (refs[num_unique - 1] == ref_id))
+            ++counts.back();
+        else
+        {
+            refs[num_unique++] = ref_id;
+            counts.push_back(1);
+        }
+    refs.resize(num_unique);
+}
+
+// pcdata of the params that can hold references, see getClassRefParamMap
+// every pcdata for classes we have no template of
+template <typename Func>
+static void forEachRefPcdata(pugi::xml_node obj, Func&& func)
+{
+    auto& class_map = getClassRefParamMap();
+    auto  it        = class_map.find(std::string_view(obj.attribute("class").as_string()));
+    if (it == class_map.end())
+    {
+        forEachPcdata(obj, func);
+        return;
+    }
+
+    auto&       params = it->second;
+    std::string path;
+    auto        visit = [&](pugi::xml_node parent, auto& self) -> void {
+        for (auto param : parent.children("hkparam"))
+        {
+            auto len = path.size();
+            path += param.attribute("name").as_string();
+            if (params.refs.contains(path))
+            {
+                if (auto text = param.first_child(); text.type() == pugi::node_pcdata)
+                    func(text);
+            }
+            else if (params.structs.contains(path))
+            {
+                path += '/';
+                for (auto child : param.children("hkobject"))
+                    self(child, self);
+            }
+            path.resize(len);
+        }
+    };
+    visit(obj, visit);
+}
+
+#ifndef NDEBUG
+// refs in params the table misses are invisible to the graph, report each class/param once per load
+static void checkRefCoverage(pugi::xml_node obj, StringSet& reported, spdlog::logger& logger)
+{
+    std::vector<pugi::xml_node_struct*> covered;
+    forEachRefPcdata(obj, [&](pugi::xml_node node) { covered.push_back(node.internal_object()); });
+    forEachPcdata(obj, [&](pugi::xml_node node) {
+        bool has_ref = false;
+        forEachRef(node.value(), [&](size_t, std::string_view) { has_ref = true; });
+        if (!has_ref || (std::ranges::find(covered, node.internal_object()) != covered.end()))
+            return;
+        auto key = fmt::format("{}/{}", obj.attribute("class").as_string(), node.parent().attribute("name").as_string());
+        if (reported.insert(key).second)
+            logger.warn("References in {} (e.g. {}) aren't covered by g_ref_array_params.", key, obj.attribute("name").as_string());
+    });
+}
+#endif
+
+// finds every top level hkobject in the text without parsing it
+// skeleton is the text with each of them replaced by an empty element with the same attributes
+static bool scanRawObjects(std::string_view text, std::string& skeleton, std::vector<std::string_view>& objs)
+{
+    auto tagAt = [&](size_t pos, std::string_view tag) { return text.substr(pos, tag.size()) == tag; };
+
+    auto pos = text.find("<hksection");
+    if ((pos == text.npos) || ((pos = text.find('>', pos)) == text.npos))
+        return false;
+    skeleton.assign(text.substr(0, ++pos));
+
+    while (true)
+    {
+        if ((pos = text.find('<', pos)) == text.npos)
+            return false;
+        if (tagAt(pos, "</hksection"))
+            break;
+        if (tagAt(pos, "<!--"))
+        {
+            if ((pos = text.find("-->", pos)) == text.npos)
+                return false;
+            continue;
+        }
+        if (!tagAt(pos, "<hkobject"))
+            return false;
+
+        // nested hkobjects are unnamed structs
+        auto   obj_begin = pos;
+        size_t depth     = 0;
+        do
+        {
+            if (tagAt(pos, "<!--"))
+                pos = text.find("-->", pos);
+            else if (tagAt(pos, "<hkobject"))
+            {
+                if ((pos = text.find('>', pos)) != text.npos && (text[pos - 1] != '/'))
+                    ++depth;
+            }
+            else if (tagAt(pos, "</hkobject"))
+            {
+                pos = text.find('>', pos);
+                --depth;
+            }
+            if (pos == text.npos)
+                return false;
+            ++pos;
+        } while (depth && ((pos = text.find('<', pos)) != text.npos));
+        if (pos == text.npos)
+            return false;
+
+        auto obj       = text.substr(obj_begin, pos - obj_begin);
+        auto start_tag = obj.substr(0, obj.find('>'));
+        if (start_tag.ends_with('/'))
+            start_tag.remove_suffix(1);
+        objs.push_back(obj);
+        skeleton.append("\n").append(start_tag).append("/>");
+    }
+    skeleton.append("\n").append(text.substr(pos));
+
+    return true;
+}
+
+// id from the start tag of a scanned object
+static ObjId rawObjId(std::string_view raw_obj)
+{
+    auto start_tag = raw_obj.substr(0, raw_obj.find('>'));
+    auto name_pos  = start_tag.find(" name=\"");
+    if (name_pos == start_tag.npos)
+        return g_invalid_id;
+    auto name = start_tag.substr(name_pos + 7);
+    return parseObjId(name.substr(0, name.find('"')));
+}
+
+// everything that ends up in the saved file, never 0
+static uint64_t hashObj(pugi::xml_node obj)
+{
+    uint64_t hash = 0;
+    auto     mix  = [&](uint64_t val) { hash = (hash ^ val) * 0x100000001b3; };
+    auto     mixStr = [&](const char* str) { mix(robin_hood::hash_bytes(str, strlen(str))); };
+
+    auto   node  = obj;
+    size_t depth = 0;
+    while (true)
+    {
+        mix((depth << 8) | node.type());
+        mixStr(node.name());
+        mixStr(node.value());
+        for (auto attr : node.attributes())
+        {
+            mixStr(attr.name());
+            mixStr(attr.value());
+        }
+
+        if (node.first_child())
+        {
+            node = node.first_child();
+            ++depth;
+            continue;
+        }
+        while ((node != obj) && !node.next_sibling())
+        {
+            node = node.parent();
+            --depth;
+        }
+        if (node == obj)
+            break;
+        node = node.next_sibling();
+    }
+    return hash ? hash : 1;
+}
+
+struct StringWriter : pugi::xml_writer
 {
+    std::string* out;
+    virtual void write(const void* data, size_t size) override { out->append(static_cast<const char*>(data), size); }
+};
+
+void HkxFile::loadFile(std::string_view path, LoadMode mode)
+{
+    finishSave(true);
+
     m_path     = path;
     m_filename = std::filesystem::path(path).filename().string();
 
@@ -20,7 +265,63 @@ void HkxFile::loadFile(std::string_view path)
 
     auto file_logger = spdlog::default_logger()->clone(m_filename);
 
-    auto result = m_doc.load_file(path.data(), pugi::parse_default & (~pugi::parse_escapes));
+    m_doc.reset(); // drop nodes pointing into the old mapping first
+    m_mapped_file = std::make_shared<MappedFile>(); // a pending save may still hold the old one
+    if ((mode != kLoadCopy) && !m_mapped_file->open(path))
+    {
+        file_logger->warn("Failed to map file, falling back to regular loading.");
+        mode = kLoadCopy;
+    }
+
+    // binary packfiles aren't supported, say so instead of failing as broken xml
+    {
+        char magic[8] = {};
+        if (mode != kLoadCopy)
+            std::memcpy(magic, m_mapped_file->data(), std::min(sizeof(magic), m_mapped_file->size()));
+        else if (std::ifstream stream(std::string(path), std::ios::binary); stream)
+            stream.read(magic, sizeof(magic));
+        if (!std::memcmp(magic, "\x57\xe0\xe0\x57\x10\xc0\xc0\x10", sizeof(magic)))
+        {
+            file_logger->error("Binary packfiles are not supported. Please convert it to xml (e.g. with hkxcmd) first.");
+            return;
+        }
+    }
+
+    // hash before parsing, in place parsing writes into the buffer
+    IndexCache index_cache;
+    bool       use_cache = false;
+    if (mode != kLoadCopy)
+    {
+        std::error_code ec;
+        index_cache.file_size = m_mapped_file->size();
+        index_cache.mtime     = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+        index_cache.hash      = robin_hood::hash_bytes(m_mapped_file->data(), m_mapped_file->size());
+
+        IndexCache old_cache;
+        if (old_cache.read(path) && old_cache.matches(index_cache.file_size, index_cache.mtime, index_cache.hash))
+        {
+            index_cache = std::move(old_cache);
+            use_cache   = true;
+        }
+    }
+    auto index_start = std::chrono::steady_clock::now();
+
+    // lazy: the mapping stays untouched, only the skeleton gets parsed
+    std::string                   skeleton;
+    std::vector<std::string_view> raw_objs;
+    if ((mode == kLoadLazy) && !scanRawObjects({m_mapped_file->data(), m_mapped_file->size()}, skeleton, raw_objs))
+    {
+        file_logger->warn("Couldn't scan objects for lazy loading, loading everything instead.");
+        mode = kLoadMapped;
+    }
+
+    pugi::xml_parse_result result;
+    if (mode == kLoadLazy)
+        result = m_doc.load_buffer(skeleton.data(), skeleton.size(), g_parse_flags);
+    else if (mode == kLoadMapped)
+        result = m_doc.load_buffer_inplace(m_mapped_file->data(), m_mapped_file->size(), g_parse_flags);
+    else
+        result = m_doc.load_file(path.data(), g_parse_flags);
     if (!result)
     {
         file_logger->error("File parsed with errors.\n\tError description: {}\n\tat location {}", path, result.description(), result.offset);
@@ -28,6 +329,17 @@ void HkxFile::loadFile(std::string_view path)
     }
     file_logger->info("File parsed without errors.", path);
 
+    if (mode == kLoadLazy)
+        file_logger->info("Bytes mapped: {}, bytes copied: {} (lazy, {} objects unparsed)", m_mapped_file->size(), skeleton.size(), raw_objs.size());
+    else if (mode == kLoadMapped)
+    {
+        // pugixml only copies the buffer when it has to convert the encoding
+        size_t bytes_copied = m_mapped_file->contains(m_doc.first_child().name()) ? 0 : m_mapped_file->size();
+        file_logger->info("Bytes mapped: {}, bytes copied: {}", m_mapped_file->size(), bytes_copied);
+    }
+    else
+        file_logger->info("Bytes copied: {}", std::filesystem::file_size(path));
+
     // get the data node
     m_data_node = m_doc.child("hkpackfile").child("hksection");
     if (!m_data_node)
@@ -39,50 +351,225 @@ void HkxFile::loadFile(std::string_view path)
     m_latest_id = 0;
 
     m_obj_list.clear();
+    m_obj_count = 0;
     m_obj_class_list.clear();
     m_obj_ref_list.clear();
+    m_obj_ref_count.clear();
     m_obj_ref_by_list.clear();
-
-    // populate node list
+    ++m_graph_version;
+    m_obj_raw.clear();
+    m_lazy_obj_count = 0;
+    m_free_ids       = {};
+    m_obj_hash.clear();
+    m_journal_hash.clear();
+    m_edited_ids.clear();
+    m_unsaved_ids.clear();
+    m_numeric_arrays.clear();
+
+    std::vector<pugi::xml_node> ref_nodes;           // pcdata holding references
+    bool                        is_canonical = true; // every id already in "#0123" form
+
+    size_t num_objs = raw_objs.size();
+    if (mode != kLoadLazy)
+        for (auto hkobject = m_data_node.child("hkobject"); hkobject; hkobject = hkobject.next_sibling("hkobject"))
+            ++num_objs;
+    auto max_id = maxObjId(num_objs);
+
+    ObjId root_id = g_invalid_id;
     for (auto hkobject = m_data_node.child("hkobject"); hkobject; hkobject = hkobject.next_sibling("hkobject"))
     {
-        std::string name = hkobject.attribute("name").as_string();
-        if (name.empty() || !name.starts_with('#'))
+        std::string_view name = hkobject.attribute("name").as_string();
+        auto             id   = parseObjId(name);
+        if (id == g_invalid_id)
         {
             file_logger->error("hkobject at location {} has no valid name.", hkobject.path());
             return;
         }
+        if (id > max_id)
+        {
+            file_logger->error("hkobject {} has an id far past the object count ({}). Renumber it below {} first.", name, num_objs, max_id);
+            return;
+        }
+        if (isObj(id))
+        {
+            file_logger->error("hkobject {} is defined more than once.", name);
+            return;
+        }
 
-        std::string hkclass = hkobject.attribute("class").as_string();
+        std::string_view hkclass = hkobject.attribute("class").as_string();
         if (hkclass.empty())
         {
             file_logger->error("hkobject {} has no class.", name);
             return;
         }
 
-        m_obj_list[name] = hkobject;
+        if (id >= m_obj_list.size())
+        {
+            m_obj_list.resize(id + 1);
+            m_obj_ref_list.resize(id + 1);
+        }
+        m_obj_list[id] = hkobject;
+        if (mode == kLoadLazy) // shells are in the same order as the scanned objects
+        {
+            m_obj_raw.resize(m_obj_list.size());
+            m_obj_raw[id] = raw_objs[m_obj_count];
+            ++m_lazy_obj_count;
+        }
+        ++m_obj_count;
         if (!m_obj_class_list.contains(hkclass))
-            m_obj_class_list[hkclass] = {};
-        m_obj_class_list[hkclass].push_back(name);
+            m_obj_class_list[std::string(hkclass)] = {};
+        m_obj_class_list.find(hkclass)->second.push_back(id);
+        if ((root_id == g_invalid_id) && (hkclass == "hkRootLevelContainer"))
+            root_id = id;
 
-        uint16_t id = std::atoi(name.data() + 1); // There's a potential crash here...
         m_latest_id = std::max(id, m_latest_id);
+        is_canonical &= (name == objId2Str(id));
     }
 
-    m_root_obj = m_data_node.find_child_by_attribute("class", "hkRootLevelContainer");
+    m_root_obj = getObj(root_id);
     if (!m_root_obj)
     {
         file_logger->error("Couldn't find root level object!");
         return;
     }
+    m_obj_raw.resize(m_obj_list.size());
+
+    // references, from the sidecar if it still describes this file
+    use_cache = use_cache && (index_cache.objects.size() == m_obj_count) &&
+        std::ranges::all_of(index_cache.objects, [&](const IndexCache::Object& obj) { return isObj(obj.id); });
+#ifndef NDEBUG
+    StringSet uncovered_refs;
+#endif
+    if (use_cache)
+        for (size_t i = 0; i < index_cache.objects.size(); ++i)
+            m_obj_ref_list[index_cache.objects[i].id] = std::move(index_cache.refs[i]);
+    else
+        for (ObjId id = 0; id < m_obj_list.size(); ++id)
+        {
+            if (!m_obj_list[id])
+                continue;
+
+            auto& refs = m_obj_ref_list[id];
+            if (auto raw = m_obj_raw[id]; !raw.empty())
+            {
+                forEachRef(raw.substr(raw.find('>')), [&](size_t, std::string_view token) {
+                    auto ref_id = parseObjId(token);
+                    refs.push_back(ref_id);
+                    is_canonical &= (token == objId2Str(ref_id));
+                });
+                continue;
+            }
+#ifndef NDEBUG
+            checkRefCoverage(m_obj_list[id], uncovered_refs, *file_logger);
+#endif
+            forEachRefPcdata(m_obj_list[id], [&](pugi::xml_node node) {
+                auto ref_count = refs.size();
+                forEachRef(node.value(), [&](size_t, std::string_view token) {
+                    auto ref_id = parseObjId(token);
+                    refs.push_back(ref_id);
+                    is_canonical &= (token == objId2Str(ref_id));
+                });
+                if (refs.size() != ref_count)
+                    ref_nodes.push_back(node);
+            });
+        }
+
+    // drop dangling refs and fill the reverse edges
+    m_obj_ref_list.resize(m_obj_list.size());
+    m_obj_ref_count.resize(m_obj_list.size());
+    m_obj_ref_by_list.resize(m_obj_list.size());
+    for (ObjId id = 0; id < m_obj_list.size(); ++id)
+    {
+        auto& refs = m_obj_ref_list[id];
+        std::ranges::sort(refs);
+        std::erase_if(refs, [&](ObjId ref_id) { return !isObj(ref_id); });
+        countRefs(refs, m_obj_ref_count[id]);
+        for (auto ref_id : refs)
+            m_obj_ref_by_list[ref_id].push_back(id);
+    }
+
+    // in case some file don't follow the 4 digit indexing
+    // sidecars are only written for canonical files, so a warm load never needs this
+    auto first_id   = std::ranges::find_if(m_obj_list, [](pugi::xml_node obj) { return bool(obj); }) - m_obj_list.begin();
+    bool is_compact = (first_id == 100) && (m_latest_id - 99 == m_obj_count);
+    if (!is_canonical || !is_compact)
+        reindexObjInternal(100, &ref_nodes);
+
+    file_logger->info("Objects indexed in {} ms ({}).",
+                      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - index_start).count(),
+                      use_cache ? "warm, from index cache" : "cold");
+
+    // the sidecar has to describe the file on disk, so not after a load time reindex
+    if ((mode != kLoadCopy) && !use_cache && is_canonical && is_compact)
+    {
+        StringMap<uint32_t> class_idx;
+        for (auto& [hkclass, ids] : m_obj_class_list)
+        {
+            class_idx[hkclass] = (uint32_t)index_cache.classes.size();
+            index_cache.classes.push_back(hkclass);
+        }
+        for (ObjId id = 0; id < m_obj_list.size(); ++id)
+            if (m_obj_list[id])
+            {
+                auto offset = m_obj_raw[id].empty() ? m_obj_list[id].offset_debug() : (m_obj_raw[id].data() - m_mapped_file->data());
+                index_cache.objects.push_back({id,
+                                               class_idx.find(std::string_view(m_obj_list[id].attribute("class").as_string()))->second,
+                                               (uint64_t)offset});
+                auto& refs = index_cache.refs.emplace_back();
+                for (size_t i = 0; i < m_obj_ref_list[id].size(); ++i)
+                    refs.insert(refs.end(), m_obj_ref_count[id][i], m_obj_ref_list[id][i]);
+            }
+        if (!index_cache.write(path))
+            file_logger->info("Couldn't write index cache, next load will be cold as well.");
+    }
 
-    reindexObjInternal(); // in case some file don't follow the 4 digit indexing
+    if (is_canonical && is_compact)
+        recordObjHashes();
+    m_unsaved_ids.clear(); // a load time reindex alone doesn't need saving
+
+    replayJournal();
 
     m_loaded = true;
 }
 
-void HkxFile::saveFile(std::string_view path)
+// everything a save needs, so the writing can happen on another thread while the document gets edited
+struct HkxFile::SaveSnapshot
 {
+    std::string path, tmp_path;
+    std::string journal_path; // of the file we saved from, covered by this save
+
+    std::shared_ptr<MappedFile>   lazy_source; // keeps unparsed objects alive
+    MappedFile                    disk_source; // unchanged objects
+    std::vector<std::string>      texts;       // serialized header and changed objects
+    std::vector<std::string_view> pieces;      // the whole file in order
+    std::vector<uint64_t>         new_hashes;
+    std::vector<ObjId>            unsaved_ids; // put back if the write fails
+
+    bool write()
+    {
+        {
+            std::ofstream stream(tmp_path, std::ios::binary);
+            for (auto piece : pieces)
+                stream.write(piece.data(), piece.size());
+            if (!stream)
+                return false;
+        }
+        // written next to the target first, the old file may still be mapped
+        return replaceFile(tmp_path, path);
+    }
+};
+
+void HkxFile::saveFile(std::string_view path, bool async)
+{
+    finishSave(true);
+    beforeSave();
+    snapshotForSave(path);
+    launchSave(async);
+}
+
+void HkxFile::snapshotForSave(std::string_view path)
+{
+    auto source_path = m_path;
     if (path.empty())
         path = m_path;
     else
@@ -93,89 +580,649 @@ void HkxFile::saveFile(std::string_view path)
 
     file_logger->info("Saving file...");
 
-    if (!m_doc.save_file(path.data(), "    ", pugi::format_default | pugi::format_no_escapes))
-        file_logger->warn("Failed to save file!");
+    m_save_snapshot               = makeSaveSnapshot(source_path);
+    m_save_snapshot->unsaved_ids.assign(m_unsaved_ids.begin(), m_unsaved_ids.end());
+    m_unsaved_ids.clear();
+    m_save_snapshot->path         = path;
+    m_save_snapshot->tmp_path     = std::string(path) + ".tmp";
+    m_save_snapshot->journal_path = source_path + ".journal";
 }
 
-void HkxFile::addRef(std::string_view id, std::string_view parent_id)
+void HkxFile::launchSave(bool async)
 {
-    if (getObj(id) && getObj(parent_id))
+    if (async)
+        m_save_result = std::async(std::launch::async, [snapshot = m_save_snapshot]() { return snapshot->write(); });
+    else
     {
-        m_obj_ref_list.find(parent_id)->second.emplace(id);
-        m_obj_ref_by_list.find(id)->second.emplace(parent_id);
+        std::promise<bool> result;
+        result.set_value(m_save_snapshot->write());
+        m_save_result = result.get_future();
+        finishSave(true);
     }
 }
-void HkxFile::deRef(std::string_view id, std::string_view parent_id)
+
+void HkxFile::finishSave(bool wait)
 {
-    auto file_logger = spdlog::default_logger()->clone(m_filename);
+    if (!m_save_result.valid() ||
+        (!wait && (m_save_result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)))
+        return;
+
+    auto file_logger = spdlog::default_logger()->clone(std::filesystem::path(m_save_snapshot->path).filename().string());
 
-    if (getObj(id) && getObj(parent_id))
+    if (m_save_result.get())
     {
-        auto& ref_by_list = m_obj_ref_by_list.find(id)->second;
-        if (ref_by_list.contains(parent_id))
-            ref_by_list.erase(std::string{parent_id});
-        else
-            file_logger->warn("Attempting to dereference {0} from {1} but {0} is not referenced by {1}!", id, parent_id);
+        // what's on disk now is the base of the next save
+        // objects edited after the snapshot just won't match their hash
+        if (m_save_snapshot->path == m_path)
+        {
+            m_journal_hash = m_save_snapshot->new_hashes;
+            m_obj_hash     = std::move(m_save_snapshot->new_hashes);
+            std::error_code ec;
+            m_disk_size  = std::filesystem::file_size(m_path, ec);
+            m_disk_mtime = std::filesystem::last_write_time(m_path, ec).time_since_epoch().count();
+            discardJournal();
+
+            // edited after the snapshot, the journal just deleted may have been their only copy
+            m_edited_ids.insert(m_unsaved_ids.begin(), m_unsaved_ids.end());
+        }
+        std::error_code ec;
+        std::filesystem::remove(m_save_snapshot->journal_path, ec);
 
-        auto& ref_list = m_obj_ref_list.find(parent_id)->second;
-        if (ref_list.contains(id))
-            ref_list.erase(std::string{id});
+        // stale now, the next load writes a fresh one
+        std::filesystem::remove(IndexCache::getCachePath(m_save_snapshot->path), ec);
+
+        file_logger->info("File saved.");
+    }
+    else
+    {
+        m_unsaved_ids.insert(m_save_snapshot->unsaved_ids.begin(), m_save_snapshot->unsaved_ids.end());
+        file_logger->warn("Failed to save file!");
+    }
+
+    m_save_snapshot.reset();
+}
+
+std::vector<uint64_t> HkxFile::hashObjs()
+{
+    std::vector<uint64_t> hashes(m_obj_list.size(), 0);
+    std::for_each(std::execution::par,
+                  hashes.begin(), hashes.end(),
+                  [&](uint64_t& hash) {
+                      ObjId id = &hash - hashes.data();
+                      if (m_obj_list[id] && ((id >= m_obj_raw.size()) || m_obj_raw[id].empty()))
+                          hash = hashObj(m_obj_list[id]);
+                  });
+    return hashes;
+}
+
+bool HkxFile::hasUnsavedChanges()
+{
+    if (!m_loaded || m_unsaved_ids.empty())
+        return false;
+    if (m_obj_hash.empty() || !isDiskFileUnchanged(m_path)) // nothing to compare against
+        return true;
+
+    // edits may have been undone by hand
+    return std::ranges::any_of(m_unsaved_ids, [&](ObjId id) {
+        if ((id < m_obj_raw.size()) && !m_obj_raw[id].empty())
+            return false;
+        auto new_hash = isObj(id) ? hashObj(m_obj_list[id]) : 0;
+        return new_hash != ((id < m_obj_hash.size()) ? m_obj_hash[id] : 0);
+    });
+}
+
+void HkxFile::recordObjHashes()
+{
+    m_obj_hash = hashObjs();
+
+    std::error_code ec;
+    m_disk_size  = std::filesystem::file_size(m_path, ec);
+    m_disk_mtime = std::filesystem::last_write_time(m_path, ec).time_since_epoch().count();
+}
+
+bool HkxFile::isDiskFileUnchanged(std::string_view path)
+{
+    std::error_code ec;
+    auto            size  = std::filesystem::file_size(path, ec);
+    auto            mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return !ec && (size == m_disk_size) && (mtime == m_disk_mtime);
+}
+
+// same output as xml_document::save_file, except
+// unparsed objects are copied from the mapping and unchanged objects from the file on disk as they are
+std::shared_ptr<HkxFile::SaveSnapshot> HkxFile::makeSaveSnapshot(const std::string& source_path)
+{
+    auto file_logger = spdlog::default_logger()->clone(m_filename);
+    auto snapshot    = std::make_shared<SaveSnapshot>();
+
+    auto& new_hashes = snapshot->new_hashes;
+    new_hashes       = hashObjs();
+
+    // a fresh view, the loaded mapping may have been parsed in place
+    std::string                   skeleton;
+    std::vector<std::string_view> source_objs;
+    std::vector<std::string_view> source_raw(m_obj_list.size());
+    if (!m_obj_hash.empty() && isDiskFileUnchanged(source_path) && snapshot->disk_source.open(source_path) &&
+        scanRawObjects({snapshot->disk_source.data(), snapshot->disk_source.size()}, skeleton, source_objs))
+        for (auto raw : source_objs)
+            if (auto id = rawObjId(raw); (id < source_raw.size()) && (id < m_obj_hash.size()) && (m_obj_hash[id] == new_hashes[id]))
+                source_raw[id] = raw;
+    if (m_lazy_obj_count)
+        snapshot->lazy_source = m_mapped_file;
+
+    // pick the pieces, changed objects get serialized afterwards in parallel (reading pugixml is thread safe)
+    auto writeStartTag = [](pugi::xml_node node, std::string_view indent) {
+        std::string retval = fmt::format("{}<{}", indent, node.name());
+        for (auto attr : node.attributes())
+            retval += fmt::format(" {}=\"{}\"", attr.name(), attr.value());
+        return retval + ">\n";
+    };
+
+    constexpr std::string_view obj_indent = "        ", obj_end = "\n";
+
+    std::vector<pugi::xml_node> changed_objs;
+    std::vector<size_t>         changed_pieces;
+    auto&                       pieces = snapshot->pieces;
+
+    snapshot->texts.push_back("<?xml version=\"1.0\"?>\n" + writeStartTag(m_data_node.parent(), "") + writeStartTag(m_data_node, "    "));
+    pieces.push_back({});
+    for (auto child : m_data_node.children())
+    {
+        auto id  = parseObjId(child.attribute("name").as_string());
+        auto raw = ((id < m_obj_raw.size()) && !m_obj_raw[id].empty()) ? m_obj_raw[id] :
+            (id < source_raw.size())                                   ? source_raw[id] :
+                                                                         std::string_view{};
+        if (raw.empty())
+        {
+            changed_objs.push_back(child);
+            changed_pieces.push_back(pieces.size());
+            pieces.push_back({});
+        }
         else
-            file_logger->warn("Attempting to dereference {0} from {1} but {1} is not referencing {0}!", id, parent_id);
+            pieces.insert(pieces.end(), {obj_indent, raw, obj_end});
     }
+    pieces.push_back("    </hksection>\n</hkpackfile>\n");
+
+    snapshot->texts.resize(changed_objs.size() + 1);
+    std::for_each(std::execution::par,
+                  changed_objs.begin(), changed_objs.end(),
+                  [&](pugi::xml_node& obj) {
+                      StringWriter writer;
+                      writer.out = &snapshot->texts[&obj - changed_objs.data() + 1];
+                      obj.print(writer, "    ", pugi::format_default | pugi::format_no_escapes, pugi::encoding_auto, 2);
+                  });
+    pieces[0] = snapshot->texts[0];
+    for (size_t i = 0; i < changed_pieces.size(); ++i)
+        pieces[changed_pieces[i]] = snapshot->texts[i + 1];
+
+    file_logger->info("{} objects copied as they were, {} written.", getObjCount() - changed_objs.size(), changed_objs.size());
+
+    return snapshot;
 }
 
-void HkxFile::buildRefList()
+// a header naming the file on disk the edits apply to, then one record per change
+//   O <id> <length>\n<hkobject>\n   object added or changed
+//   D <id>\n                        object deleted
+// only objects reported through markObjEdited are looked at, and written if their hash changed
+void HkxFile::writeJournal()
 {
-    m_obj_ref_by_list.clear();
-    m_obj_ref_list.clear();
+    if (!m_loaded)
+        return;
+
+    flushNumericArrays();
+    if (m_edited_ids.empty())
+        return;
 
-    for (auto& [_, obj] : m_obj_list)
+    std::vector<ObjId> ids(m_edited_ids.begin(), m_edited_ids.end());
+    std::ranges::sort(ids);
+    m_journal_hash.resize(std::max<size_t>(m_journal_hash.size(), ids.back() + 1));
+
+    std::vector<std::pair<ObjId, uint64_t>> new_hashes;
+    std::string                             records;
+    for (auto id : ids)
+    {
+        if (!isObj(id))
+        {
+            records += fmt::format("D {}\n", id); // harmless if the journal never had it
+            new_hashes.push_back({id, 0});
+            continue;
+        }
+        if ((id < m_obj_raw.size()) && !m_obj_raw[id].empty())
+            continue; // never parsed, so never edited either
+        auto new_hash = hashObj(m_obj_list[id]);
+        if (new_hash == m_journal_hash[id])
+            continue;
+
+        std::string  text;
+        StringWriter writer;
+        writer.out = &text;
+        m_obj_list[id].print(writer, "", pugi::format_raw | pugi::format_no_escapes);
+        records += fmt::format("O {} {}\n", id, text.size());
+        records += text;
+        records += '\n';
+        new_hashes.push_back({id, new_hash});
+    }
+    if (!records.empty())
     {
-        m_obj_ref_by_list[obj.attribute("name").as_string()] = {};
-        m_obj_ref_list[obj.attribute("name").as_string()]    = {};
+        auto            journal_path = getJournalPath();
+        std::error_code ec;
+        bool            is_new = !std::filesystem::exists(journal_path, ec);
+        std::ofstream   stream(journal_path, std::ios::binary | std::ios::app);
+        if (is_new)
+            stream << fmt::format("HVJ1 {} {}\n",
+                                  std::filesystem::file_size(m_path, ec),
+                                  std::filesystem::last_write_time(m_path, ec).time_since_epoch().count());
+        stream.write(records.data(), records.size());
+        stream.flush();
+
+        // on failure everything is written again next time, records can be replayed twice just fine
+        if (!stream)
+        {
+            spdlog::default_logger()->clone(m_filename)->warn("Failed to write the edit journal.");
+            return;
+        }
     }
+    for (auto [id, hash] : new_hashes)
+        m_journal_hash[id] = hash;
+    m_edited_ids.clear();
+}
 
-    for (auto& [id, obj] : m_obj_list)
-        buildRefList(id);
+void HkxFile::markObjEdited(ObjId id)
+{
+    if (id == g_invalid_id)
+        return;
+    m_edited_ids.insert(id);
+    m_unsaved_ids.insert(id);
+    onObjChanged(id);
 }
-void HkxFile::buildRefList(std::string_view id)
+
+void HkxFile::flushNumericArrays()
 {
-    auto obj = getObj(id);
-    if (!obj) return;
+    for (auto it = m_numeric_arrays.begin(); it != m_numeric_arrays.end();)
+    {
+        if (!it->second.used)
+        {
+            it = m_numeric_arrays.erase(it); // not shown anymore, already written back when it last was
+            continue;
+        }
+        flushNumericArray(it->second.hkparam);
+        it->second.used = false;
+        ++it;
+    }
+}
 
-    auto refed_objs = m_obj_ref_list.find(id)->second;
-    for (auto ref_obj_id : refed_objs)
-        deRef(ref_obj_id, id);
+void HkxFile::flushNumericArray(pugi::xml_node hkparam)
+{
+    auto it = m_numeric_arrays.find(hkparam.internal_object());
+    if (it == m_numeric_arrays.end())
+        return;
+    std::visit(
+        [&](auto& values) {
+            auto text = printVector(values);
+            if ((text == hkparam.text().as_string()) && (values.size() == hkparam.attribute("numelements").as_ullong()))
+                return;
+            hkparam.text()                   = text.c_str();
+            hkparam.attribute("numelements") = values.size();
+            markEdited(hkparam);
+        },
+        it->second.values);
+}
 
-    struct Walker : pugi::xml_tree_walker
-    {
-        StringSet* m_refs;
+void HkxFile::dropNumericArrays(pugi::xml_node obj)
+{
+    for (auto it = m_numeric_arrays.begin(); it != m_numeric_arrays.end();)
+        if (it->second.obj == obj)
+            it = m_numeric_arrays.erase(it);
+        else
+            ++it;
+}
 
-        virtual bool for_each(pugi::xml_node& node)
+void HkxFile::discardJournal()
+{
+    std::error_code ec;
+    std::filesystem::remove(getJournalPath(), ec);
+}
+
+void HkxFile::replayJournal()
+{
+    auto file_logger  = spdlog::default_logger()->clone(m_filename);
+    auto journal_path = getJournalPath();
+
+    if (std::ifstream stream(journal_path, std::ios::binary); stream)
+    {
+        std::string     magic;
+        uint64_t        size  = 0;
+        int64_t         mtime = 0;
+        std::error_code ec;
+        stream >> magic >> size >> mtime;
+        if ((magic != "HVJ1") ||
+            (size != std::filesystem::file_size(m_path, ec)) ||
+            (mtime != std::filesystem::last_write_time(m_path, ec).time_since_epoch().count()))
         {
-            if (node.type() == pugi::node_pcdata)
+            stream.close();
+            std::filesystem::rename(journal_path, journal_path + ".old", ec);
+            file_logger->warn("Found unsaved edits for a different version of this file, they are kept in {}.old", journal_path);
+        }
+        else
+        {
+            auto               root_id = parseObjId(m_root_obj.attribute("name").as_string());
+            std::vector<ObjId> changed_ids;
+            size_t             num_records = 0;
+
+            // stops at a record cut short by the crash
+            char  type;
+            ObjId id;
+            while (stream >> type >> id)
             {
-                std::string text = node.value();
-                size_t      pos  = text.find('#');
-                while (pos != text.npos)
+                if (type == 'O')
                 {
-                    if ((!pos || (text[pos - 1] != '&')) && // in case html entity, fuck html entities
-                        (pos + 1 < text.size()) &&
-                        ((text[pos + 1] >= '0') && (text[pos + 1] <= '9'))) // #IND #INF etc.
-                        m_refs->emplace(&text[pos], 5);
-                    pos = text.find('#', pos + 1);
+                    size_t      len;
+                    std::string text;
+                    if (!(stream >> len) || (stream.get() != '\n'))
+                        break;
+                    text.resize(len);
+                    if (!stream.read(text.data(), len))
+                        break;
+
+                    pugi::xml_document obj_doc;
+                    if (!obj_doc.load_buffer(text.data(), text.size(), g_parse_flags))
+                        break;
+                    auto src = obj_doc.first_child();
+
+                    // in place if possible, other code may be holding the node
+                    auto obj = getObj(id);
+                    if (obj && strcmp(obj.attribute("class").as_string(), src.attribute("class").as_string()))
+                    {
+                        unregisterObj(id);
+                        obj = {};
+                    }
+                    if (obj)
+                    {
+                        markObjEdited(id);
+                        for (auto attr : src.attributes())
+                            (obj.attribute(attr.name()) ? obj.attribute(attr.name()) : obj.append_attribute(attr.name())).set_value(attr.value());
+                        obj.remove_children();
+                        for (auto child : src.children())
+                            obj.append_copy(child);
+                    }
+                    else if (!registerObj(id, m_data_node.append_copy(src)))
+                        break; // garbage id, don't trust the rest either
+                    changed_ids.push_back(id);
                 }
-                node.text() = text.c_str();
+                else if (type == 'D')
+                {
+                    if (isObj(id))
+                        unregisterObj(id);
+                    markObjEdited(id);
+                }
+                else
+                    break;
+                ++num_records;
             }
-            return true; // continue traversal
+
+            for (auto changed_id : changed_ids)
+                buildRefList(changed_id);
+
+            // holes left by deletes
+            m_free_ids = {};
+            for (ObjId free_id = 100; free_id < m_latest_id; ++free_id)
+                if (!isObj(free_id))
+                    m_free_ids.push(free_id);
+
+            m_root_obj = getObj(root_id);
+
+            if (num_records)
+                file_logger->warn("Recovered {} unsaved edits from the last session. Save the file to keep them.", num_records);
         }
-    } walker;
-    walker.m_refs = &m_obj_ref_list.find(id)->second;
-    obj.traverse(walker);
+    }
+
+    m_journal_hash = hashObjs();
+    m_edited_ids.clear(); // replayed records are in the journal already
+}
+
+void HkxFile::materializeObj(ObjId id)
+{
+    auto raw = std::exchange(m_obj_raw[id], {});
+    --m_lazy_obj_count;
 
-    for (auto& refed_id : *walker.m_refs)
-        m_obj_ref_by_list.find(refed_id)->second.emplace(id);
+    pugi::xml_document obj_doc;
+    if (auto result = obj_doc.load_buffer(raw.data(), raw.size(), g_parse_flags); !result)
+    {
+        spdlog::default_logger()->clone(m_filename)->error("Object {} parsed with errors.\n\tError description: {}", getObjName(id), result.description());
+        return;
+    }
+    // into the shell so node handles stay valid
+    for (auto child : obj_doc.first_child().children())
+        m_obj_list[id].append_copy(child);
+    onObjChanged(id); // there are nodes to point at now
+    if ((id < m_obj_hash.size()) || (id < m_journal_hash.size()))
+    {
+        auto hash = hashObj(m_obj_list[id]); // same as on disk and so in the journal
+        if (id < m_obj_hash.size())
+            m_obj_hash[id] = hash;
+        if (id < m_journal_hash.size())
+            m_journal_hash[id] = hash;
+    }
+}
+void HkxFile::materializeAll()
+{
+    if (!m_lazy_obj_count)
+        return;
+    for (ObjId id = 0; id < m_obj_raw.size(); ++id)
+        if (!m_obj_raw[id].empty())
+            materializeObj(id);
+}
+
+void HkxFile::addRef(ObjId id, ObjId parent_id)
+{
+    if (isObj(id) && isObj(parent_id))
+    {
+        auto& ref_list = m_obj_ref_list[parent_id];
+        auto& counts   = m_obj_ref_count[parent_id];
+        auto  it       = std::ranges::lower_bound(ref_list, id);
+        if ((it != ref_list.end()) && (*it == id))
+            ++counts[it - ref_list.begin()];
+        else
+        {
+            counts.insert(counts.begin() + (it - ref_list.begin()), 1);
+            ref_list.insert(it, id);
+            m_obj_ref_by_list[id].push_back(parent_id);
+            ++m_graph_version;
+        }
+    }
+}
+void HkxFile::deRef(ObjId id, ObjId parent_id)
+{
+    auto file_logger = spdlog::default_logger()->clone(m_filename);
+
+    if (isObj(id) && isObj(parent_id))
+    {
+        auto& ref_list = m_obj_ref_list[parent_id];
+        auto& counts   = m_obj_ref_count[parent_id];
+        auto  it       = std::ranges::lower_bound(ref_list, id);
+        if ((it == ref_list.end()) || (*it != id))
+        {
+            file_logger->warn("Attempting to dereference {0} from {1} but {1} is not referencing {0}!", getObjName(id), getObjName(parent_id));
+            return;
+        }
+        if (--counts[it - ref_list.begin()]) // still referenced somewhere else in the parent
+            return;
+        counts.erase(counts.begin() + (it - ref_list.begin()));
+        ref_list.erase(it);
+        ++m_graph_version;
+
+        auto& ref_by_list = m_obj_ref_by_list[id];
+        if (auto it = std::ranges::find(ref_by_list, parent_id); it != ref_by_list.end())
+            ref_by_list.erase(it);
+        else
+            file_logger->warn("Attempting to dereference {0} from {1} but {0} is not referenced by {1}!", getObjName(id), getObjName(parent_id));
+    }
+}
+void HkxFile::replaceRef(ObjId parent_id, ObjId old_id, ObjId new_id)
+{
+    if (old_id == new_id)
+        return;
+    deRef(old_id, parent_id);
+    addRef(new_id, parent_id);
+}
+void HkxFile::deRefNode(pugi::xml_node node)
+{
+    // same params the counts came from, a "#0150" in some name isn't a ref
+    auto obj       = getParentObj(node);
+    auto parent_id = parseObjId(obj.attribute("name").as_string());
+    forEachRefPcdata(obj, [&](pugi::xml_node text) {
+        auto iter = text;
+        while (iter && (iter != node) && (iter != obj))
+            iter = iter.parent();
+        if (iter == node)
+            forEachRef(text.value(), [&](size_t, std::string_view token) { deRef(parseObjId(token), parent_id); });
+    });
+}
+
+void HkxFile::scanObjRefs(ObjId id, std::vector<ObjId>& out)
+{
+    if (!isObj(id)) return;
+
+    auto ref_begin = out.size();
+    auto pushRef   = [&](size_t, std::string_view token) { out.push_back(parseObjId(token)); };
+    if ((id < m_obj_raw.size()) && !m_obj_raw[id].empty()) // no parsing here, this runs in parallel
+        forEachRef(m_obj_raw[id].substr(m_obj_raw[id].find('>')), pushRef);
+    else
+        forEachRefPcdata(m_obj_list[id], [&](pugi::xml_node node) { forEachRef(node.value(), pushRef); });
+
+    std::ranges::sort(out.begin() + ref_begin, out.end());
+    std::erase_if(out, [&](ObjId ref_id) { return !isObj(ref_id); }); // dangling refs, shouldn't happen
+}
+
+const RefGraph& HkxFile::getRefGraph()
+{
+    if (m_ref_graph_version == m_graph_version)
+        return m_ref_graph;
+
+    auto compress = [&](const std::vector<std::vector<ObjId>>& adj_list, std::vector<uint32_t>& offsets, std::vector<ObjId>& edges) {
+        offsets.assign(m_obj_list.size() + 1, 0);
+        for (ObjId id = 0; id < m_obj_list.size(); ++id)
+            offsets[id + 1] = offsets[id] + (uint32_t)adj_list[id].size();
+        edges.resize(offsets.back());
+        for (ObjId id = 0; id < m_obj_list.size(); ++id)
+            std::ranges::copy(adj_list[id], edges.begin() + offsets[id]);
+    };
+    compress(m_obj_ref_list, m_ref_graph.m_child_offsets, m_ref_graph.m_children);
+    compress(m_obj_ref_by_list, m_ref_graph.m_parent_offsets, m_ref_graph.m_parents);
+
+    // reserved in full so walks never reallocate
+    m_ref_graph.m_visit_mark.assign(m_obj_list.size(), 0);
+    m_ref_graph.m_mark = 0;
+    m_ref_graph.m_prev.assign(m_obj_list.size(), g_invalid_id);
+    m_ref_graph.m_queue.clear();
+    m_ref_graph.m_queue.reserve(m_obj_list.size());
+
+    m_ref_graph_version = m_graph_version;
+    return m_ref_graph;
+}
+
+void HkxFile::updateStateIndex()
+{
+    if (m_state_index_version == m_graph_version)
+        return;
+
+    // bfs down from all state machines at once, the first to reach an object is the closest above it
+    auto& graph = getRefGraph();
+    m_owner_state_machine.assign(graph.size(), g_invalid_id);
+    std::vector<ObjId> queue;
+    if (auto it = m_obj_class_list.find("hkbStateMachine"); it != m_obj_class_list.end())
+        for (auto id : it->second)
+        {
+            m_owner_state_machine[id] = id;
+            queue.push_back(id);
+        }
+    for (size_t head = 0; head < queue.size(); ++head)
+        for (auto child_id : graph.getChildren(queue[head]))
+            if (m_owner_state_machine[child_id] == g_invalid_id)
+            {
+                m_owner_state_machine[child_id] = m_owner_state_machine[queue[head]];
+                queue.push_back(child_id);
+            }
+
+    m_state_ids.clear();
+    m_state_index_version = m_graph_version;
+}
+
+ObjId HkxFile::getOwnerStateMachine(ObjId id)
+{
+    updateStateIndex();
+    return (id < m_owner_state_machine.size()) ? m_owner_state_machine[id] : g_invalid_id;
+}
+
+const HkxFile::StateIdSet& HkxFile::getStateIds(ObjId state_machine_id)
+{
+    updateStateIndex();
+    if (auto it = m_state_ids.find(state_machine_id); it != m_state_ids.end())
+        return it->second;
+
+    auto& state_ids = m_state_ids[state_machine_id];
+    if (getObjClass(state_machine_id) != "hkbStateMachine")
+        return state_ids;
+    // "states" only holds state infos and nothing else in a state machine does
+    for (auto ref_id : getRefedObjs(state_machine_id))
+        if (getObjClass(ref_id) == "hkbStateMachineStateInfo")
+            state_ids.states.push_back({getObj(ref_id).getByName("stateId").text().as_int(), ref_id});
+    std::ranges::sort(state_ids.states);
+    if (!state_ids.states.empty())
+        state_ids.max_id = state_ids.states.back().first;
+    return state_ids;
+}
+
+void HkxFile::buildRefList()
+{
+    // objects are disjoint subtrees, so ranges of them are scanned in parallel into local edge lists
+    constexpr size_t chunk_size = 256;
+
+    std::vector<std::vector<std::pair<ObjId, ObjId>>> chunk_edges((m_obj_list.size() + chunk_size - 1) / chunk_size);
+    std::for_each(std::execution::par,
+                  chunk_edges.begin(), chunk_edges.end(),
+                  [&](std::vector<std::pair<ObjId, ObjId>>& edges) {
+                      size_t             begin = (&edges - chunk_edges.data()) * chunk_size;
+                      size_t             end   = std::min(begin + chunk_size, m_obj_list.size());
+                      std::vector<ObjId> refs;
+                      for (auto id = static_cast<ObjId>(begin); id < end; ++id)
+                      {
+                          refs.clear();
+                          scanObjRefs(id, refs);
+                          for (auto ref_id : refs)
+                              edges.emplace_back(id, ref_id);
+                      }
+                  });
+
+    // merge, chunks are in id order so forward lists come out sorted
+    m_obj_ref_list.assign(m_obj_list.size(), {});
+    m_obj_ref_count.assign(m_obj_list.size(), {});
+    m_obj_ref_by_list.assign(m_obj_list.size(), {});
+    for (auto& edges : chunk_edges)
+        for (auto [id, ref_id] : edges)
+            m_obj_ref_list[id].push_back(ref_id);
+    for (ObjId id = 0; id < m_obj_list.size(); ++id)
+    {
+        countRefs(m_obj_ref_list[id], m_obj_ref_count[id]);
+        for (auto ref_id : m_obj_ref_list[id])
+            m_obj_ref_by_list[ref_id].push_back(id);
+    }
+    ++m_graph_version;
+}
+void HkxFile::buildRefList(ObjId id)
+{
+    if (!isObj(id)) return;
+
+    auto& refs = m_obj_ref_list[id];
+    for (auto ref_id : refs)
+        std::erase(m_obj_ref_by_list[ref_id], id);
+
+    refs.clear();
+    scanObjRefs(id, refs);
+    countRefs(refs, m_obj_ref_count[id]);
+    for (auto ref_id : refs)
+        m_obj_ref_by_list[ref_id].push_back(id);
+    ++m_graph_version;
 }
 
 std::string_view HkxFile::addObj(std::string_view hkclass)
@@ -183,7 +1230,7 @@ std::string_view HkxFile::addObj(std::string_view hkclass)
     auto file_logger = spdlog::default_logger()->clone(m_filename);
 
     file_logger->info("Attempting to add new {} ...", hkclass);
-    if (m_latest_id >= 9999)
+    if (m_free_ids.empty() && HkxFileManager::getSingleton()->m_short_ids && (m_latest_id >= 9999))
     {
         file_logger->warn("Exceeding object id limit (9999). Consider doing some cleaning or making a separate file for one of the branches.");
         return {};
@@ -192,20 +1239,23 @@ std::string_view HkxFile::addObj(std::string_view hkclass)
     auto& class_def_map = getClassDefaultMap();
     if (class_def_map.contains(hkclass))
     {
-        auto new_obj              = appendXmlString(m_data_node, class_def_map.at(hkclass));
-        auto id_str               = std::format("#{:04}", ++m_latest_id);
-        new_obj.attribute("name") = id_str.c_str();
+        ObjId id;
+        if (!m_free_ids.empty())
+        {
+            id = m_free_ids.top();
+            m_free_ids.pop();
+        }
+        else if ((id = ++m_latest_id) == 10000)
+            file_logger->warn("Object ids now go past #9999. Turn on 4-digit ids and reindex if your tools can't handle that.");
 
-        m_obj_list[id_str] = new_obj;
-        if (!m_obj_class_list.contains(hkclass))
-            m_obj_class_list[std::string(hkclass)] = {};
-        m_obj_class_list.find(hkclass)->second.push_back(id_str);
-        m_obj_ref_by_list[id_str] = {};
-        m_obj_ref_list[id_str]    = {};
+        auto new_obj              = appendXmlString(m_data_node, class_def_map.at(hkclass));
+        new_obj.attribute("name") = objId2Str(id).c_str();
+        if (!registerObj(id, new_obj))
+            return {};
 
-        file_logger->info("Added new object {}", id_str);
+        file_logger->info("Added new object {}", getObjName(id));
         HkxFileManager::getSingleton()->dispatch(kEventObjChanged);
-        return m_obj_list.find(id_str)->first;
+        return getObjName(id);
     }
     else
     {
@@ -213,55 +1263,227 @@ std::string_view HkxFile::addObj(std::string_view hkclass)
         return {};
     }
 }
-void HkxFile::delObj(std::string_view id)
+void HkxFile::delObj(std::string_view id_str)
 {
     auto file_logger = spdlog::default_logger()->clone(m_filename);
 
-    file_logger->info("Attempting to delete object {} ...", id);
+    file_logger->info("Attempting to delete object {} ...", id_str);
 
+    auto id  = parseObjId(id_str);
     auto obj = getObj(id);
     if (!obj)
     {
-        file_logger->warn("No object {}", id);
+        file_logger->warn("No object {}", id_str);
         return;
     }
 
-    if (isObjEssential(id))
+    if (isObjEssential(id_str))
     {
-        file_logger->warn("Object {} is essential.", id);
+        file_logger->warn("Object {} is essential.", id_str);
         return;
     }
 
-    auto hkclass = obj.attribute("class").as_string();
-
     if (hasRef(id))
     {
-        file_logger->warn("Object {} is still referenced by other objects.", id);
+        file_logger->warn("Object {} is still referenced by other objects.", id_str);
         return;
     }
 
-    m_data_node.remove_child(obj);
+    std::string id_copy(id_str); // id_str could be pointing at the name of the node
+    unregisterObj(id);
 
-    m_obj_list.erase(m_obj_list.find(id));
+    file_logger->info("Object {} deleted.", id_copy);
+    HkxFileManager::getSingleton()->dispatch(kEventObjChanged);
+}
 
-    auto class_list = m_obj_class_list.find(hkclass);
+bool HkxFile::registerObj(ObjId id, pugi::xml_node obj)
+{
+    if (id > maxObjId(m_obj_count))
+    {
+        spdlog::default_logger()->clone(m_filename)->warn("Object id {} is far past the object count ({}), dropped it.", id, m_obj_count);
+        m_data_node.remove_child(obj);
+        return false;
+    }
+    if (id >= m_obj_list.size())
+    {
+        m_obj_list.resize(id + 1);
+        m_obj_ref_list.resize(id + 1);
+        m_obj_ref_count.resize(id + 1);
+        m_obj_ref_by_list.resize(id + 1);
+    }
+    m_obj_list[id] = obj;
+    ++m_obj_count;
+    ++m_graph_version;
+    m_latest_id = std::max(m_latest_id, id);
+    markObjEdited(id);
+
+    std::string_view hkclass = obj.attribute("class").as_string();
+    if (!m_obj_class_list.contains(hkclass))
+        m_obj_class_list[std::string(hkclass)] = {};
+    m_obj_class_list.find(hkclass)->second.push_back(id);
+    return true;
+}
+void HkxFile::unregisterObj(ObjId id)
+{
+    auto class_list = m_obj_class_list.find(m_obj_list[id].attribute("class").as_string());
     std::erase(class_list->second, id);
     if (class_list->second.empty())
         m_obj_class_list.erase(class_list);
 
-    for (auto& parent_id : m_obj_ref_by_list.find(id)->second)
-        m_obj_ref_list[parent_id].erase(m_obj_ref_list[parent_id].find(id));
-    for (auto& child_id : m_obj_ref_list.find(id)->second)
-        m_obj_ref_by_list[child_id].erase(m_obj_ref_by_list[child_id].find(id));
+    unlinkObj(id);
+}
+void HkxFile::unlinkObj(ObjId id)
+{
+    for (auto child_id : m_obj_ref_list[id])
+        std::erase(m_obj_ref_by_list[child_id], id);
+    for (auto parent_id : m_obj_ref_by_list[id])
+    {
+        auto& ref_list = m_obj_ref_list[parent_id];
+        if (auto it = std::ranges::lower_bound(ref_list, id); (it != ref_list.end()) && (*it == id))
+        {
+            m_obj_ref_count[parent_id].erase(m_obj_ref_count[parent_id].begin() + (it - ref_list.begin()));
+            ref_list.erase(it);
+        }
+    }
+    m_obj_ref_list[id].clear();
+    m_obj_ref_count[id].clear();
+    m_obj_ref_by_list[id].clear();
 
-    m_obj_ref_by_list.erase(m_obj_ref_by_list.find(id));
-    m_obj_ref_list.erase(m_obj_ref_list.find(id));
+    if ((id < m_obj_raw.size()) && !m_obj_raw[id].empty())
+    {
+        m_obj_raw[id] = {};
+        --m_lazy_obj_count;
+    }
+    dropNumericArrays(m_obj_list[id]);
+    m_data_node.remove_child(m_obj_list[id]);
+    m_obj_list[id] = {};
+    --m_obj_count;
+    m_free_ids.push(id);
+    ++m_graph_version;
+    markObjEdited(id);
+}
 
-    file_logger->info("Object {} deleted.", id);
+size_t HkxFile::delObjs(std::span<const ObjId> ids)
+{
+    auto file_logger = spdlog::default_logger()->clone(m_filename);
+
+    // an object can go if everything referencing it goes as well
+    // dropping one from the set means rechecking what it references
+    std::vector<bool>  doomed(m_obj_list.size());
+    std::vector<ObjId> to_check;
+    for (auto id : ids)
+        if (isObj(id))
+        {
+            doomed[id] = true;
+            to_check.push_back(id);
+        }
+    auto num_requested = to_check.size();
+    while (!to_check.empty())
+    {
+        auto id = to_check.back();
+        to_check.pop_back();
+        if (!doomed[id])
+            continue;
+        if (std::ranges::any_of(m_obj_ref_by_list[id], [&](ObjId parent_id) { return !doomed[parent_id]; }) ||
+            isObjEssential(id))
+        {
+            doomed[id] = false;
+            for (auto ref_id : m_obj_ref_list[id])
+                if (doomed[ref_id])
+                    to_check.push_back(ref_id);
+        }
+    }
+
+    std::vector<ObjId> del_ids;
+    for (ObjId id = 0; id < doomed.size(); ++id)
+        if (doomed[id])
+            del_ids.push_back(id);
+    if (del_ids.size() != num_requested)
+        file_logger->warn("{} objects are essential or still referenced by other objects, kept them.", num_requested - del_ids.size());
+    if (del_ids.empty())
+        return 0;
+
+    // class lists in one go instead of per object
+    std::vector<std::string> empty_classes;
+    for (auto& [hkclass, class_ids] : m_obj_class_list)
+    {
+        std::erase_if(class_ids, [&](ObjId id) { return doomed[id]; });
+        if (class_ids.empty())
+            empty_classes.push_back(hkclass);
+    }
+    for (auto& hkclass : empty_classes)
+        m_obj_class_list.erase(hkclass);
+
+    for (auto id : del_ids)
+        unlinkObj(id);
+
+    file_logger->info("{} objects deleted.", del_ids.size());
     HkxFileManager::getSingleton()->dispatch(kEventObjChanged);
+    return del_ids.size();
+}
+
+size_t HkxFile::delSubtree(ObjId id)
+{
+    auto file_logger = spdlog::default_logger()->clone(m_filename);
+
+    if (!isObj(id))
+    {
+        file_logger->warn("No object {}", objId2Str(id));
+        return 0;
+    }
+    if (hasRef(id))
+    {
+        file_logger->warn("Object {} is still referenced by other objects.", getObjName(id));
+        return 0;
+    }
+
+    std::vector<bool>  seen(m_obj_list.size());
+    std::vector<ObjId> subtree = {id}, stack = {id};
+    seen[id]                   = true;
+    while (!stack.empty())
+    {
+        auto parent_id = stack.back();
+        stack.pop_back();
+        for (auto ref_id : m_obj_ref_list[parent_id])
+            if (!seen[ref_id])
+            {
+                seen[ref_id] = true;
+                subtree.push_back(ref_id);
+                stack.push_back(ref_id);
+            }
+    }
+    return delObjs(subtree);
+}
+
+std::vector<ObjId> HkxFile::getUnreachableObjs()
+{
+    std::vector<bool>  reached(m_obj_list.size());
+    std::vector<ObjId> stack;
+    if (auto root_id = parseObjId(m_root_obj.attribute("name").as_string()); isObj(root_id))
+    {
+        reached[root_id] = true;
+        stack.push_back(root_id);
+    }
+    while (!stack.empty())
+    {
+        auto id = stack.back();
+        stack.pop_back();
+        for (auto ref_id : m_obj_ref_list[id])
+            if (!reached[ref_id])
+            {
+                reached[ref_id] = true;
+                stack.push_back(ref_id);
+            }
+    }
+
+    std::vector<ObjId> retval;
+    for (ObjId id = 0; id < m_obj_list.size(); ++id)
+        if (m_obj_list[id] && !reached[id])
+            retval.push_back(id);
+    return retval;
 }
 
-void HkxFile::reindexObj(uint16_t start_id)
+void HkxFile::reindexObj(ObjId start_id)
 {
     auto file_logger = spdlog::default_logger()->clone(m_filename);
 
@@ -270,120 +1492,127 @@ void HkxFile::reindexObj(uint16_t start_id)
     reindexObjInternal(start_id);
 
     file_logger->info("All objects reindexed.");
+    if (HkxFileManager::getSingleton()->m_short_ids && (m_latest_id > 9999))
+        file_logger->warn("There are still more objects than 4-digit ids allow.");
     HkxFileManager::getSingleton()->dispatch(kEventObjChanged);
 }
 
-void HkxFile::reindexObjInternal(uint16_t start_id)
+void HkxFile::reindexObjInternal(ObjId start_id, std::vector<pugi::xml_node>* ref_nodes)
 {
+    // every reference text could change
+    if (m_lazy_obj_count)
+    {
+        materializeAll();
+        ref_nodes = nullptr;
+    }
+
     // get the id map
-    StringMap<std::string> remap = {};
-
-    auto                     new_idx = start_id;
-    std::vector<std::string> obj_list;
-    getObjList(obj_list);
-    std::ranges::sort(obj_list);
-    for (auto& id : obj_list)
-    {
-        remap[id] = fmt::format("#{:04}", new_idx);
-        ++new_idx;
-    }
-    // for (uint16_t i = 0; i <= m_latest_id; ++i)
-    //     if (auto old_id_str = fmt::format("#{:04}", i); m_obj_list.contains(old_id_str))
-    //     {
-    //         remap[old_id_str] = fmt::format("#{:04}", new_idx);
-    //         ++new_idx;
-    //     }
+    std::vector<ObjId> remap(m_obj_list.size(), g_invalid_id);
+
+    auto new_idx = start_id;
+    for (ObjId id = 0; id < m_obj_list.size(); ++id)
+        if (m_obj_list[id])
+            remap[id] = new_idx++;
+    // everything moves, the journal has to drop the old ids and get the new ones
+    for (ObjId id = 0; id < std::max<size_t>(m_obj_list.size(), new_idx); ++id)
+        markObjEdited(id);
     m_latest_id = new_idx - 1;
+    m_free_ids  = {};
+    m_obj_hash.clear(); // nothing matches the file on disk anymore
 
     // remap the lists
     {
-        decltype(m_obj_list) new_list = {};
-        for (auto& [key, val] : m_obj_list)
-            new_list[remap[key]] = val;
-        m_obj_list = new_list;
-    }
-    {
-        decltype(m_obj_class_list) new_list = {};
-        for (auto& [key, val] : m_obj_class_list)
-            new_list[key] = {};
-        std::for_each(std::execution::par,
-                      m_obj_class_list.begin(), m_obj_class_list.end(),
-                      [&](auto& pair) {
-                          std::ranges::transform(pair.second, std::back_inserter(new_list[pair.first]), [&](const std::string& item) { return remap[item]; });
-                      });
-        m_obj_class_list = new_list;
+        decltype(m_obj_list) new_list(new_idx);
+        for (ObjId id = 0; id < m_obj_list.size(); ++id)
+            if (m_obj_list[id])
+                new_list[remap[id]] = m_obj_list[id];
+        m_obj_list = std::move(new_list);
     }
-    {
-        decltype(m_obj_ref_by_list) new_list = {};
-        for (auto& [key, val] : m_obj_ref_by_list)
-            new_list[remap[key]] = {};
+    std::for_each(std::execution::par,
+                  m_obj_class_list.begin(), m_obj_class_list.end(),
+                  [&](auto& pair) {
+                      for (auto& id : pair.second)
+                          id = remap[id];
+                  });
+    auto remap_adj_list = [&](std::vector<std::vector<ObjId>>& adj_list) {
+        std::vector<std::vector<ObjId>> new_list(new_idx);
+        for (ObjId id = 0; id < adj_list.size(); ++id)
+            if (remap[id] != g_invalid_id)
+                new_list[remap[id]] = std::move(adj_list[id]);
         std::for_each(std::execution::par,
-                      m_obj_ref_by_list.begin(), m_obj_ref_by_list.end(),
-                      [&](auto& pair) {
-                          auto& new_set = new_list[remap[pair.first]];
-                          std::ranges::transform(pair.second, std::inserter(new_set, new_set.end()), [&](const std::string& item) { return remap[item]; });
+                      new_list.begin(), new_list.end(),
+                      [&](std::vector<ObjId>& refs) {
+                          for (auto& id : refs)
+                              id = remap[id];
+                          std::ranges::sort(refs); // order is kept anyway but whatever
                       });
-        m_obj_ref_by_list = new_list;
-    }
+        adj_list = std::move(new_list);
+    };
+    remap_adj_list(m_obj_ref_list);
+    remap_adj_list(m_obj_ref_by_list);
+    ++m_graph_version;
     {
-        decltype(m_obj_ref_list) new_list = {};
-        for (auto& [key, val] : m_obj_ref_list)
-            new_list[remap[key]] = {};
-        std::for_each(std::execution::par,
-                      m_obj_ref_list.begin(), m_obj_ref_list.end(),
-                      [&](auto& pair) {
-                          auto& new_set = new_list[remap[pair.first]];
-                          std::ranges::transform(pair.second, std::inserter(new_set, new_set.end()), [&](const std::string& item) { return remap[item]; });
-                      });
-        m_obj_ref_list = new_list;
+        decltype(m_obj_ref_count) new_counts(new_idx); // ids keep their order, so the counts still line up
+        for (ObjId id = 0; id < m_obj_ref_count.size(); ++id)
+            if (remap[id] != g_invalid_id)
+                new_counts[remap[id]] = std::move(m_obj_ref_count[id]);
+        m_obj_ref_count = std::move(new_counts);
     }
 
     // remap the xml
-    struct Walker : pugi::xml_tree_walker
+    std::vector<pugi::xml_node> found_ref_nodes;
+    if (!ref_nodes)
     {
-        StringMap<std::string>* m_remap;
-
-        virtual bool for_each(pugi::xml_node& node)
-        {
-            if (node.type() == pugi::node_pcdata)
-            {
-                std::string text = node.value();
-                size_t      pos  = text.find('#');
-                while (pos != text.npos)
-                {
-                    if ((!pos || (text[pos - 1] != '&')) && // in case html entity, fuck html entities
-                        (pos + 1 < text.size()) &&
-                        ((text[pos + 1] >= '0') && (text[pos + 1] <= '9'))) // #IND #INF etc
-                    {
-                        auto next_break = pos + 1;
-                        while ((next_break != text.size()) && (text[next_break] >= '0') && (text[next_break] <= '9'))
-                            ++next_break;
-                        auto rep_len = next_break - pos;
-                        text.replace(pos, rep_len, m_remap->at(std::string(&text[pos], rep_len)));
-                        pos = next_break;
-                    }
-
-                    pos = text.find('#', pos + 1);
-                }
-                node.text() = text.c_str();
-            }
-            return true; // continue traversal
-        }
-    } walker;
-    walker.m_remap = &remap;
-    m_data_node.traverse(walker);
-
-    for (auto [key, obj] : m_obj_list)
-        obj.attribute("name") = key.c_str();
+        for (auto obj : m_obj_list)
+            if (obj)
+                forEachRefPcdata(obj, [&](pugi::xml_node node) {
+                    bool has_ref = false;
+                    forEachRef(node.value(), [&](size_t, std::string_view) { has_ref = true; });
+                    if (has_ref)
+                        found_ref_nodes.push_back(node);
+                });
+        ref_nodes = &found_ref_nodes;
+    }
+    std::vector<std::string> new_texts(ref_nodes->size());
+    std::transform(std::execution::par,
+                   ref_nodes->begin(), ref_nodes->end(), new_texts.begin(),
+                   [&](pugi::xml_node node) {
+                       std::string_view old_text = node.value();
+                       std::string      new_text;
+                       size_t           copied_pos = 0;
+                       forEachRef(old_text, [&](size_t pos, std::string_view token) {
+                           auto old_id = parseObjId(token);
+                           if ((old_id >= remap.size()) || (remap[old_id] == g_invalid_id))
+                               return;
+                           if (auto new_id_str = objId2Str(remap[old_id]); new_id_str != token)
+                           {
+                               new_text.append(old_text.substr(copied_pos, pos - copied_pos)).append(new_id_str);
+                               copied_pos = pos + token.size();
+                           }
+                       });
+                       if (copied_pos) // something changed
+                           new_text.append(old_text.substr(copied_pos));
+                       return new_text;
+                   });
+    for (size_t i = 0; i < new_texts.size(); ++i) // pugixml allocation isn't thread safe
+        if (!new_texts[i].empty())
+            (*ref_nodes)[i].set_value(new_texts[i].c_str());
+
+    for (ObjId id = 0; id < m_obj_list.size(); ++id)
+        if (auto id_str = objId2Str(id); m_obj_list[id] && (id_str != m_obj_list[id].attribute("name").as_string()))
+            m_obj_list[id].attribute("name") = id_str.c_str();
 
     m_data_node.parent().attribute("toplevelobject") = m_root_obj.attribute("name").as_string();
 }
 
 //////////////////// BEHAVIOUR
 
-void BehaviourFile::loadFile(std::string_view path)
+void BehaviourFile::loadFile(std::string_view path, LoadMode mode)
 {
-    HkxFile::loadFile(path);
+    m_linked_usage_built = false; // rebuilt on first use
+    m_linked_usage_stale.clear();
+
+    HkxFile::loadFile(path, mode);
     if (!m_loaded)
         return;
 
@@ -392,8 +1621,8 @@ void BehaviourFile::loadFile(std::string_view path)
     m_loaded = false;
 
     // get essential nodes
-    m_graph_obj = m_data_node.find_child_by_attribute("class", "hkbBehaviorGraph");
-    if (!(m_graph_obj && isRefBy(m_graph_obj.attribute("name").as_string(), m_root_obj)))
+    m_graph_obj = getFirstObjByClass("hkbBehaviorGraph");
+    if (!(m_graph_obj && std::ranges::binary_search(getRefedObjs(parseObjId(m_root_obj.attribute("name").as_string())), parseObjId(m_graph_obj.attribute("name").as_string()))))
     {
         file_logger->error("Couldn't find behavior graph!");
         return;
@@ -433,194 +1662,188 @@ void BehaviourFile::loadFile(std::string_view path)
     m_evt_manager.buildEntryList(evt_name_node, evt_info_node);
     m_prop_manager.buildEntryList(prop_name_node, prop_info_node);
 
-    buildRefList();
 
     file_logger->info("File successfully loaded with {} hkobjects, {} hkclasses, {} variables, {} animation events and {} character properties",
-                      m_obj_list.size(), m_obj_class_list.size(), m_var_manager.size(), m_evt_manager.size(), m_prop_manager.size());
+                      getObjCount(), m_obj_class_list.size(), m_var_manager.size(), m_evt_manager.size(), m_prop_manager.size());
     m_loaded = true;
 }
 
-void BehaviourFile::saveFile(std::string_view path)
+void BehaviourFile::beforeSave()
 {
-    reindexEvents();
-    reindexProps();
-    reindexVariables();
-
-    HkxFile::saveFile(path);
+    HkxFile::beforeSave();
+    reindexLinked(true, true, true);
 }
 
-// Should've used xpath but whatever
-pugi::xml_node BehaviourFile::getFirstVarRef(size_t idx, bool ret_obj)
-{
-    auto var_idx_node = m_data_node.find_node([=](auto node) { return isVarNode(node) && (node.text().as_ullong() == idx); });
-    if (var_idx_node)
-        return ret_obj ? getParentObj(var_idx_node) : var_idx_node;
-    return {};
-}
+pugi::xml_node BehaviourFile::getFirstVarRef(size_t idx, bool ret_obj) { return getFirstLinkedRef(kLinkedVar, idx, ret_obj); }
+pugi::xml_node BehaviourFile::getFirstEventRef(size_t idx, bool ret_obj) { return getFirstLinkedRef(kLinkedEvt, idx, ret_obj); }
+pugi::xml_node BehaviourFile::getFirstPropRef(size_t idx, bool ret_obj) { return getFirstLinkedRef(kLinkedProp, idx, ret_obj); }
 
-pugi::xml_node BehaviourFile::getFirstEventRef(size_t idx, bool ret_obj)
+pugi::xml_node BehaviourFile::getFirstLinkedRef(LinkedNodeType type, size_t idx, bool ret_obj)
 {
-    auto evt_idx_node = m_data_node.find_node([=](auto node) { return isEvtNode(node) && (node.text().as_ullong() == idx); });
-    if (evt_idx_node)
-        return ret_obj ? getParentObj(evt_idx_node) : evt_idx_node;
+    updateLinkedUsage();
+    auto usage = getLinkedUsage(type, idx);
+    if (usage.empty())
+        return {};
+    auto id  = usage.front().obj;
+    auto obj = getObj(id);
+    if (ret_obj || usage.front().hkparam)
+        return ret_obj ? obj : usage.front().hkparam;
+
+    // it was scanned unparsed, getObj just parsed it
+    scanLinkedUsage(id);
+    m_linked_usage_stale.erase(id);
+    for (auto& site : getLinkedUsage(type, idx))
+        if (site.obj == id)
+            return site.hkparam;
     return {};
 }
-pugi::xml_node BehaviourFile::getFirstPropRef(size_t idx, bool ret_obj)
+
+void BehaviourFile::reindexVariables() { reindexLinked(true, false, false); }
+void BehaviourFile::reindexEvents() { reindexLinked(false, true, false); }
+void BehaviourFile::reindexProps() { reindexLinked(false, false, true); }
+
+void BehaviourFile::reindexLinked(bool vars, bool evts, bool props)
 {
-    auto prop_idx_node = m_data_node.find_node([=](auto node) { return isPropNode(node) && (node.text().as_ullong() == idx); });
-    if (prop_idx_node)
-        return ret_obj ? getParentObj(prop_idx_node) : prop_idx_node;
-    return {};
+    // the managers rewrite their containers even when nothing changed
+    auto hashLinked = [&]() { return std::array{hashObj(m_graph_data_obj), hashObj(m_graph_str_data_obj), hashObj(m_var_value_obj)}; };
+    auto old_hashes = hashLinked();
+    remapLinkedNodes(vars ? m_var_manager.reindex() : IndexRemap{},
+                     evts ? m_evt_manager.reindex() : IndexRemap{},
+                     props ? m_prop_manager.reindex() : IndexRemap{});
+    if (hashLinked() != old_hashes)
+        markLinkedEdited();
 }
 
-void BehaviourFile::reindexVariables()
+// one pass for all three, every node only classified once
+void BehaviourFile::remapLinkedNodes(const IndexRemap& var_remap, const IndexRemap& evt_remap, const IndexRemap& prop_remap)
 {
-    auto remap = m_var_manager.reindex();
+    auto isIdentity = [](const IndexRemap& remap) { return std::ranges::all_of(remap, [](auto& pair) { return pair.first == pair.second; }); };
+    if (isIdentity(var_remap) && isIdentity(evt_remap) && isIdentity(prop_remap))
+        return; // nothing to change
 
-    struct Walker : pugi::xml_tree_walker
-    {
-        robin_hood::unordered_map<size_t, size_t>* m_remap;
+    materializeAll(); // unparsed objects may use the moved indices
 
-        virtual bool for_each(pugi::xml_node& node)
-        {
-            if ((node.type() == pugi::node_element) && isVarNode(node) && m_remap->contains(node.text().as_llong()))
-                node.text() = m_remap->at(node.text().as_llong());
-            return true; // continue traversal
-        }
-    } walker;
-    walker.m_remap = &remap;
-    m_data_node.traverse(walker);
+    const std::array<const IndexRemap*, 4> remaps = {nullptr, &var_remap, &evt_remap, &prop_remap};
+    forEachNode(m_data_node, [&](pugi::xml_node node) {
+        if (node.type() != pugi::node_element)
+            return;
+        if (auto type = getLinkedNodeType(node); type != kLinkedNone)
+            if (auto it = remaps[type]->find(node.text().as_llong()); (it != remaps[type]->end()) && (it->first != it->second))
+            {
+                node.text() = it->second;
+                markEdited(node);
+            }
+    });
 }
-void BehaviourFile::reindexEvents()
+
+void BehaviourFile::markLinkedEdited()
 {
-    auto remap = m_evt_manager.reindex();
+    for (auto obj : {m_graph_data_obj, m_graph_str_data_obj, m_var_value_obj})
+        markEdited(obj);
+}
 
-    struct Walker : pugi::xml_tree_walker
+void BehaviourFile::updateLinkedUsage()
+{
+    if (!m_linked_usage_built)
     {
-        robin_hood::unordered_map<size_t, size_t>* m_remap;
+        for (auto& usage : m_linked_usage)
+            usage.clear();
+        m_obj_linked_usage.assign(m_obj_list.size(), {});
+        for (ObjId id = 0; id < m_obj_list.size(); ++id)
+            scanLinkedUsage(id);
+        m_linked_usage_built = true;
+        m_linked_usage_stale.clear();
+        return;
+    }
 
-        virtual bool for_each(pugi::xml_node& node)
-        {
-            if ((node.type() == pugi::node_element) && isEvtNode(node) && m_remap->contains(node.text().as_llong()))
-                node.text() = m_remap->at(node.text().as_llong());
-            return true; // continue traversal
-        }
-    } walker;
-    walker.m_remap = &remap;
-    m_data_node.traverse(walker);
+    for (auto id : m_linked_usage_stale)
+        scanLinkedUsage(id);
+    m_linked_usage_stale.clear();
 }
-void BehaviourFile::reindexProps()
+
+void BehaviourFile::scanLinkedUsage(ObjId id)
 {
-    auto remap = m_prop_manager.reindex();
+    if (id >= m_obj_linked_usage.size())
+        m_obj_linked_usage.resize(id + 1);
+
+    // always dropped, a pasted object may hash the same but its nodes are new
+    auto& obj_usage = m_obj_linked_usage[id];
+    for (auto [type, idx] : obj_usage)
+        std::erase_if(m_linked_usage[type][idx], [=](const LinkedUsage& usage) { return usage.obj == id; });
+    obj_usage.clear();
+    if (!isObj(id))
+        return;
 
-    struct Walker : pugi::xml_tree_walker
+    // unparsed ones are read from the mapping w/o keeping the nodes
+    pugi::xml_document obj_doc;
+    auto               obj    = m_obj_list[id];
+    bool               parsed = (id >= m_obj_raw.size()) || m_obj_raw[id].empty();
+    if (!parsed)
     {
-        robin_hood::unordered_map<size_t, size_t>* m_remap;
+        if (!obj_doc.load_buffer(m_obj_raw[id].data(), m_obj_raw[id].size(), g_parse_flags))
+            return;
+        obj = obj_doc.first_child();
+    }
 
-        virtual bool for_each(pugi::xml_node& node)
-        {
-            if ((node.type() == pugi::node_element) && isPropNode(node) && m_remap->contains(node.text().as_llong()))
-                node.text() = m_remap->at(node.text().as_llong());
-            return true; // continue traversal
-        }
-    } walker;
-    walker.m_remap = &remap;
-    m_data_node.traverse(walker);
+    forEachNode(obj, [&](pugi::xml_node node) {
+        if (node.type() != pugi::node_element)
+            return;
+        auto type = getLinkedNodeType(node);
+        auto idx  = node.text().as_llong(-1);
+        if ((type == kLinkedNone) || (idx < 0) || (idx >= (1 << 16))) // -1 is none, anything huge is garbage
+            return;
+        auto& usage = m_linked_usage[type];
+        if ((size_t)idx >= usage.size())
+            usage.resize(idx + 1);
+        usage[idx].push_back({id, parsed ? node : pugi::xml_node{}});
+        obj_usage.push_back({type, (size_t)idx});
+    });
 }
 
 void BehaviourFile::cleanupVariables()
 {
-    robin_hood::unordered_map<size_t, bool> refmap;
+    updateLinkedUsage();
     for (size_t i = 0; i < m_var_manager.size(); ++i)
-        refmap[i] = false;
-
-    struct Walker : pugi::xml_tree_walker
-    {
-        robin_hood::unordered_map<size_t, bool>* m_refmap;
-
-        virtual bool for_each(pugi::xml_node& node)
-        {
-            if (isVarNode(node))
-                (*m_refmap)[node.text().as_ullong()] = true;
-            return true; // continue traversal
-        }
-    } walker;
-    walker.m_refmap = &refmap;
-    m_data_node.traverse(walker);
-
-    for (auto [idx, is_refed] : refmap)
-        if (!is_refed)
-            m_var_manager.delEntry(idx);
+        if (getLinkedUsage(kLinkedVar, i).empty())
+            m_var_manager.delEntry(i);
 }
 
 void BehaviourFile::cleanupEvents()
 {
-    robin_hood::unordered_map<size_t, bool> refmap;
+    updateLinkedUsage();
     for (size_t i = 0; i < m_evt_manager.size(); ++i)
-        refmap[i] = false;
-
-    struct Walker : pugi::xml_tree_walker
-    {
-        robin_hood::unordered_map<size_t, bool>* m_refmap;
-
-        virtual bool for_each(pugi::xml_node& node)
-        {
-            if (isEvtNode(node))
-                (*m_refmap)[node.text().as_ullong()] = true;
-            return true; // continue traversal
-        }
-    } walker;
-    walker.m_refmap = &refmap;
-    m_data_node.traverse(walker);
-
-    for (auto [idx, is_refed] : refmap)
-        if (!is_refed)
-            m_evt_manager.delEntry(idx);
+        if (getLinkedUsage(kLinkedEvt, i).empty())
+            m_evt_manager.delEntry(i);
 }
 
 void BehaviourFile::cleanupProps()
 {
-    robin_hood::unordered_map<size_t, bool> refmap;
+    updateLinkedUsage();
     for (size_t i = 0; i < m_prop_manager.size(); ++i)
-        refmap[i] = false;
-
-    struct Walker : pugi::xml_tree_walker
-    {
-        robin_hood::unordered_map<size_t, bool>* m_refmap;
-
-        virtual bool for_each(pugi::xml_node& node)
-        {
-            if (isPropNode(node))
-                (*m_refmap)[node.text().as_ullong()] = true;
-            return true; // continue traversal
-        }
-    } walker;
-    walker.m_refmap = &refmap;
-    m_data_node.traverse(walker);
-
-    for (auto [idx, is_refed] : refmap)
-        if (!is_refed)
-            m_prop_manager.delEntry(idx);
+        if (getLinkedUsage(kLinkedProp, i).empty())
+            m_prop_manager.delEntry(i);
 }
 
 //////////////////////    SKELLY
 
-void SkeletonFile::loadFile(std::string_view path)
+void SkeletonFile::loadFile(std::string_view path, LoadMode mode)
 {
-    HkxFile::loadFile(path);
+    HkxFile::loadFile(path, mode);
     if (!m_loaded)
         return;
     m_loaded = false;
 
     auto file_logger = spdlog::default_logger()->clone(m_filename);
 
-    auto skels = m_data_node.select_nodes("hkobject[@class='hkaSkeleton']");
-    for (auto skel : skels)
+    std::vector<std::string> skels;
+    getObjListByClass("hkaSkeleton", skels);
+    for (auto& skel_id : skels)
     {
-        if (std::string_view(skel.node().getByName("name").text().as_string()).starts_with("Ragdoll"))
-            m_skel_rag_obj = skel.node();
+        auto skel = getObj(skel_id);
+        if (std::string_view(skel.getByName("name").text().as_string()).starts_with("Ragdoll"))
+            m_skel_rag_obj = skel;
         else
-            m_skel_obj = skel.node();
+            m_skel_obj = skel;
     }
 
     if (!m_skel_obj)
@@ -643,18 +1866,18 @@ void SkeletonFile::getBoneList(std::vector<std::string_view>& out, bool ragdoll)
 
 //////////////////////    CHAR FILE
 
-void CharacterFile::loadFile(std::string_view path)
+void CharacterFile::loadFile(std::string_view path, LoadMode mode)
 {
-    HkxFile::loadFile(path);
+    HkxFile::loadFile(path, mode);
     if (!m_loaded)
         return;
     m_loaded = false;
 
     auto file_logger = spdlog::default_logger()->clone(m_filename);
 
-    m_char_data_obj     = m_data_node.find_child_by_attribute("class", "hkbCharacterData");
-    m_char_str_data_obj = m_data_node.find_child_by_attribute("class", "hkbCharacterStringData");
-    m_var_value_obj     = m_data_node.find_child_by_attribute("class", "hkbVariableValueSet");
+    m_char_data_obj     = getFirstObjByClass("hkbCharacterData");
+    m_char_str_data_obj = getFirstObjByClass("hkbCharacterStringData");
+    m_var_value_obj     = getFirstObjByClass("hkbVariableValueSet");
 
     if (!(m_char_data_obj && m_char_str_data_obj && m_var_value_obj))
     {
@@ -684,15 +1907,25 @@ void CharacterFile::loadFile(std::string_view path)
     m_prop_manager.buildEntryList(var_name_node, var_info_node, var_value_node, var_quad_node, var_ptr_node);
 
     file_logger->info("Character file successfully loaded with {} hkobjects, {} hkclasses, {} character properties",
-                      m_obj_list.size(), m_obj_class_list.size(), m_prop_manager.size());
+                      getObjCount(), m_obj_class_list.size(), m_prop_manager.size());
     m_loaded = true;
 }
 
-void CharacterFile::saveFile(std::string_view path)
+void CharacterFile::beforeSave()
 {
+    HkxFile::beforeSave();
+
+    auto hashLinked = [&]() { return std::array{hashObj(m_char_data_obj), hashObj(m_char_str_data_obj), hashObj(m_var_value_obj)}; };
+    auto old_hashes = hashLinked();
     m_prop_manager.reindex();
+    if (hashLinked() != old_hashes)
+        markLinkedEdited();
+}
 
-    HkxFile::saveFile(path);
+void CharacterFile::markLinkedEdited()
+{
+    for (auto obj : {m_char_data_obj, m_char_str_data_obj, m_var_value_obj})
+        markEdited(obj);
 }
 
 //////////////////////    FILE MANAGER
@@ -741,7 +1974,7 @@ void HkxFileManager::loadFile(std::string_view path)
 
     m_files.push_back({});
     auto& file = m_files.back();
-    file.loadFile(path);
+    file.loadFile(path, m_lazy_load ? HkxFile::kLoadLazy : HkxFile::kLoadMapped);
     if (file.isFileLoaded())
     {
         m_current_file = &m_files.back();
@@ -756,7 +1989,197 @@ void HkxFileManager::saveFile(std::string_view path)
     if (!m_current_file)
         return;
 
-    m_current_file->saveFile(path);
+    m_current_file->saveFile(path, true);
+}
+
+void HkxFileManager::saveAllFiles()
+{
+    std::vector<HkxFile*> files;
+    for (auto& file : m_files)
+        files.push_back(&file);
+    files.push_back(&m_char_file);
+    files.push_back(&m_skel_file);
+
+    for (auto file : files)
+        if (file->isFileLoaded())
+            file->finishSave(true);
+
+    // reindex, check and snapshot each file on its own, none of it reaches another file
+    std::vector<char> is_dirty(files.size()); // not vector<bool>, written in parallel
+    std::for_each(std::execution::par,
+                  files.begin(), files.end(),
+                  [&](HkxFile* const& file) {
+                      if (!file->isFileLoaded())
+                          return;
+                      file->beforeSave();
+                      if (!file->hasUnsavedChanges())
+                          return;
+                      file->snapshotForSave({});
+                      is_dirty[&file - files.data()] = true;
+                  });
+
+    // each file reports its own result through finishSave
+    size_t num_saved = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+        if (is_dirty[i])
+        {
+            files[i]->launchSave(true);
+            ++num_saved;
+        }
+
+    spdlog::info("Saving {} changed files, {} unchanged.",
+                 num_saved,
+                 std::ranges::count_if(files, [](HkxFile* file) { return file->isFileLoaded(); }) - num_saved);
+}
+
+void HkxFileManager::loadProject(std::string_view dir)
+{
+    namespace fs = std::filesystem;
+
+    if (isLoadingProject())
+    {
+        spdlog::warn("Still loading the previous project!");
+        return;
+    }
+
+    spdlog::info("Loading project: {}", dir);
+
+    auto addJob = [&](const fs::path& path, HkxFile::HkxFileType type) {
+        auto job  = std::make_unique<LoadJob>();
+        job->path = path.string();
+        job->type = type;
+        m_load_jobs.push_back(std::move(job));
+    };
+    auto getHkxFiles = [](const fs::path& folder) {
+        std::vector<fs::path> retval;
+        std::error_code       ec;
+        for (auto& entry : fs::directory_iterator(folder, ec))
+            if (entry.is_regular_file() && !_stricmp(entry.path().extension().string().c_str(), ".hkx"))
+                retval.push_back(entry.path());
+        std::ranges::sort(retval);
+        return retval;
+    };
+
+    // actors/xxx/behaviors, actors/xxx/characters, actors/xxx/character assets
+    // or just a folder of behaviours
+    fs::path root          = dir;
+    auto     behaviour_dir = fs::is_directory(root / "behaviors") ? root / "behaviors" : root;
+    for (auto& path : getHkxFiles(behaviour_dir))
+        addJob(path, HkxFile::kBehaviour);
+    if (auto char_files = getHkxFiles(root / "characters"); !char_files.empty())
+        addJob(char_files.front(), HkxFile::kCharacter);
+    if (auto skel_path = root / "character assets" / "skeleton.hkx"; fs::is_regular_file(skel_path))
+        addJob(skel_path, HkxFile::kSkeleton);
+
+    if (m_load_jobs.empty())
+    {
+        spdlog::warn("No hkx file found in {}", dir);
+        return;
+    }
+
+    m_load_thread = std::jthread([this, behaviour_mode = m_lazy_load ? HkxFile::kLoadLazy : HkxFile::kLoadMapped]() {
+        std::for_each(std::execution::par,
+                      m_load_jobs.begin(), m_load_jobs.end(),
+                      [=](std::unique_ptr<LoadJob>& job) {
+                          job->state = kLoadLoading;
+                          switch (job->type)
+                          {
+                              case HkxFile::kBehaviour:
+                                  job->file = std::make_shared<BehaviourFile>();
+                                  static_cast<BehaviourFile*>(job->file.get())->loadFile(job->path, behaviour_mode);
+                                  break;
+                              case HkxFile::kCharacter:
+                                  job->file = std::make_shared<CharacterFile>();
+                                  static_cast<CharacterFile*>(job->file.get())->loadFile(job->path);
+                                  break;
+                              case HkxFile::kSkeleton:
+                                  job->file = std::make_shared<SkeletonFile>();
+                                  static_cast<SkeletonFile*>(job->file.get())->loadFile(job->path);
+                                  break;
+                              default: break;
+                          }
+                          job->state = (job->file && job->file->isFileLoaded()) ? kLoadDone : kLoadFailed;
+                      });
+    });
+}
+
+void HkxFileManager::markEdited(pugi::xml_node node)
+{
+    for (auto& file : m_files)
+        if (file.ownsNode(node))
+            return file.markEdited(node);
+    if (m_char_file.ownsNode(node))
+        m_char_file.markEdited(node);
+    else if (m_skel_file.ownsNode(node))
+        m_skel_file.markEdited(node);
+}
+
+void HkxFileManager::discardJournals()
+{
+    for (auto& file : m_files)
+        file.discardJournal();
+    m_char_file.discardJournal();
+    m_skel_file.discardJournal();
+}
+
+void HkxFileManager::update()
+{
+    for (auto& file : m_files)
+        file.finishSave();
+    m_char_file.finishSave();
+    m_skel_file.finishSave();
+
+    if (auto now = std::chrono::steady_clock::now(); now - m_last_journal_write > std::chrono::seconds(2))
+    {
+        m_last_journal_write = now;
+        for (auto& file : m_files)
+            file.writeJournal();
+        m_char_file.writeJournal();
+        m_skel_file.writeJournal();
+    }
+
+    if (!isLoadingProject())
+        return;
+
+    bool all_finished = true;
+    for (auto& job : m_load_jobs)
+    {
+        auto state = job->state.load();
+        if (state == kLoadDone && !job->published)
+        {
+            switch (job->type)
+            {
+                case HkxFile::kBehaviour:
+                    m_files.push_back(std::move(*static_cast<BehaviourFile*>(job->file.get())));
+                    if (!m_current_file)
+                        m_current_file = &m_files.back();
+                    break;
+                case HkxFile::kCharacter:
+                    m_char_file = std::move(*static_cast<CharacterFile*>(job->file.get()));
+                    break;
+                case HkxFile::kSkeleton:
+                    m_skel_file = std::move(*static_cast<SkeletonFile*>(job->file.get()));
+                    break;
+                default: break;
+            }
+            job->file.reset();
+            job->published = true;
+            dispatch(kEventFileChanged);
+        }
+        else if (state == kLoadFailed && !job->published)
+        {
+            job->file.reset();
+            job->published = true;
+        }
+        all_finished &= job->published;
+    }
+
+    if (all_finished)
+    {
+        m_load_thread.join();
+        spdlog::info("Project loaded: {}/{} files", std::ranges::count_if(m_load_jobs, [](auto& job) { return job->state == kLoadDone; }), m_load_jobs.size());
+        m_load_jobs.clear();
+    }
 }
 } // namespace Hkx
 } // namespace Haviour
\ No newline at end of file
@@ -1,10 +1,20 @@
 #pragma once
 #include "linkedmanager.h"
+#include "mappedfile.h"
 #include "utils.h"
 
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
 #include <deque>
 #include <functional>
+#include <future>
+#include <memory>
+#include <queue>
+#include <span>
+#include <thread>
+#include <variant>
 
 #include <eventpp/eventdispatcher.h>
 #include <robin_hood.h>
@@ -19,6 +29,76 @@ enum HkxFileEventEnum
     kEventObjChanged
 };
 
+// numeric part of "#0123"
+using ObjId                  = uint32_t;
+constexpr ObjId g_invalid_id = UINT32_MAX;
+
+inline ObjId parseObjId(std::string_view id_str)
+{
+    ObjId id;
+    if ((id_str.size() < 2) || (id_str[0] != '#') ||
+        (std::from_chars(id_str.data() + 1, id_str.data() + id_str.size(), id).ec != std::errc()))
+        return g_invalid_id;
+    return id;
+}
+inline std::string objId2Str(ObjId id) { return fmt::format("#{:04}", id); }
+// ids index flat vectors, so a stray "#99999999" would allocate gigabytes
+inline size_t maxObjId(size_t num_objs) { return std::max<size_t>(num_objs * 4, 10000); }
+
+// compressed (csr) copy of the reference graph, for walking it w/o allocating
+class RefGraph
+{
+public:
+    inline size_t                 size() const { return m_child_offsets.empty() ? 0 : m_child_offsets.size() - 1; }
+    inline std::span<const ObjId> getChildren(ObjId id) const { return (id < size()) ? std::span<const ObjId>(m_children).subspan(m_child_offsets[id], m_child_offsets[id + 1] - m_child_offsets[id]) : std::span<const ObjId>{}; }
+    inline std::span<const ObjId> getParents(ObjId id) const { return (id < size()) ? std::span<const ObjId>(m_parents).subspan(m_parent_offsets[id], m_parent_offsets[id + 1] - m_parent_offsets[id]) : std::span<const ObjId>{}; }
+
+    // breadth first from start, each object once. func(id, depth) returns whether to go on past id
+    // getPrev(id) is where the walk came from, valid till the next walk
+    template <typename Func>
+    void walk(ObjId start, bool upwards, Func&& func) const
+    {
+        if (start >= size())
+            return;
+        if (!++m_mark)
+        {
+            std::ranges::fill(m_visit_mark, 0);
+            m_mark = 1;
+        }
+
+        m_queue.clear();
+        m_queue.push_back({start, 0});
+        m_visit_mark[start] = m_mark;
+        m_prev[start]       = g_invalid_id;
+        for (size_t head = 0; head < m_queue.size(); ++head)
+        {
+            auto [id, depth] = m_queue[head];
+            if (!func(id, depth))
+                continue;
+            for (auto next_id : upwards ? getParents(id) : getChildren(id))
+                if (m_visit_mark[next_id] != m_mark)
+                {
+                    m_visit_mark[next_id] = m_mark;
+                    m_prev[next_id]       = id;
+                    m_queue.push_back({next_id, depth + 1});
+                }
+        }
+    }
+    inline ObjId getPrev(ObjId id) const { return (id < size()) ? m_prev[id] : g_invalid_id; }
+
+private:
+    friend class HkxFile;
+
+    std::vector<uint32_t> m_child_offsets, m_parent_offsets; // id -> range in m_children/m_parents, one extra at the end
+    std::vector<ObjId>    m_children, m_parents;
+
+    // scratch of walk, sized once per build
+    mutable std::vector<uint32_t>                   m_visit_mark;
+    mutable uint32_t                                m_mark = 0;
+    mutable std::vector<ObjId>                      m_prev;
+    mutable std::vector<std::pair<ObjId, uint32_t>> m_queue;
+};
+
 // generic unpacked hkx
 class HkxFile
 {
@@ -32,47 +112,95 @@ public:
     };
     virtual constexpr HkxFileType getType() { return kUnknown; }
 
-    void                    loadFile(std::string_view path);
-    virtual void            saveFile(std::string_view path = {});
+    enum LoadMode
+    {
+        kLoadCopy,   // pugixml reads the file into its own buffer
+        kLoadMapped, // parse in place inside a private mapping of the file
+        kLoadLazy    // only scan the mapping, objects get parsed when first accessed
+    };
+
+    void                    loadFile(std::string_view path, LoadMode mode = kLoadMapped);
+    void                    saveFile(std::string_view path = {}, bool async = false); // async writes the file on another thread
+    void                    finishSave(bool wait = false);                            // report a finished background save, call every frame
+    void                    writeJournal();                                           // append objects marked edited since the last call to the journal
+    void                    discardJournal();                                         // on a clean close, unsaved edits are meant to go
+    inline bool             isSaving() { return m_save_result.valid(); }
+    virtual void            beforeSave() { flushNumericArrays(); } // reindexing etc., pending deletes only reach the document here
+    bool                    hasUnsavedChanges();                    // read only, so run beforeSave first
     inline bool             isFileLoaded() { return m_loaded; }
     inline std::string_view getPath() { return m_path; }
 
-    void        addRef(std::string_view id, std::string_view parent_id);
-    void        deRef(std::string_view id, std::string_view parent_id);
-    inline bool hasRef(std::string_view id) { return m_obj_ref_by_list.contains(id) && !m_obj_ref_by_list.find(id)->second.empty(); }
-    inline void getObjRefs(std::string_view id, std::vector<std::string>& out)
+    void        addRef(ObjId id, ObjId parent_id);
+    void        deRef(ObjId id, ObjId parent_id);
+    inline void addRef(std::string_view id, std::string_view parent_id) { addRef(parseObjId(id), parseObjId(parent_id)); }
+    inline void deRef(std::string_view id, std::string_view parent_id) { deRef(parseObjId(id), parseObjId(parent_id)); }
+    // one reference in parent now points somewhere else, "null" etc. for either is fine
+    void        replaceRef(ObjId parent_id, ObjId old_id, ObjId new_id);
+    inline void replaceRef(std::string_view parent_id, std::string_view old_id, std::string_view new_id) { replaceRef(parseObjId(parent_id), parseObjId(old_id), parseObjId(new_id)); }
+    void        deRefNode(pugi::xml_node node); // before removing a part of an object that may hold references
+    inline bool hasRef(ObjId id) { return !getObjRefs(id).empty(); }
+    inline bool hasRef(std::string_view id) { return hasRef(parseObjId(id)); }
+
+    // objects referencing id
+    inline std::span<const ObjId> getObjRefs(ObjId id) { return isObj(id) ? m_obj_ref_by_list[id] : std::span<const ObjId>{}; }
+    inline void                   getObjRefs(std::string_view id, std::vector<std::string>& out)
     {
-        if (m_obj_ref_by_list.contains(id))
-            for (auto& id : m_obj_ref_by_list.find(id)->second)
-                out.push_back(id);
+        for (auto ref : getObjRefs(parseObjId(id)))
+            out.emplace_back(getObjName(ref));
     }
-    inline void getRefedObjs(std::string_view id, std::vector<std::string>& out)
+    // objects referenced by id, sorted
+    inline std::span<const ObjId> getRefedObjs(ObjId id) { return isObj(id) ? m_obj_ref_list[id] : std::span<const ObjId>{}; }
+    inline void                   getRefedObjs(std::string_view id, std::vector<std::string>& out)
     {
-        auto temp_size = out.size();
-        if (m_obj_ref_list.contains(id))
-            for (auto& id : m_obj_ref_list.find(id)->second)
-                out.push_back(id);
-        std::sort(out.begin() + temp_size, out.end());
+        for (auto ref : getRefedObjs(parseObjId(id)))
+            out.emplace_back(getObjName(ref));
     }
-    void buildRefList();
-    void buildRefList(std::string_view id);
+    inline uint64_t getGraphVersion() { return m_graph_version; } // changes whenever objects or references do
+    const RefGraph& getRefGraph();                                // rebuilt on first use after a change
 
-    inline pugi::xml_node getObj(std::string_view id)
+    // state machine lookups, rebuilt on first use after a graph change
+    struct StateIdSet
     {
-        if (m_obj_list.contains(id))
-            return m_obj_list.find(id)->second; // until c++23 transparent searching for [] is implemented
-        return {};
+        std::vector<std::pair<int32_t, ObjId>> states; // (stateId, state object), sorted
+        int32_t                                max_id = -1;
+    };
+    ObjId             getOwnerStateMachine(ObjId id); // closest hkbStateMachine up the graph, could be id itself
+    const StateIdSet& getStateIds(ObjId state_machine_id);
+    inline void       invalidateStateIds() { m_state_ids.clear(); } // after editing a stateId, the graph doesn't see that
+
+    void        buildRefList();
+    void        buildRefList(ObjId id);
+    inline void buildRefList(std::string_view id) { buildRefList(parseObjId(id)); }
+
+    inline bool           isObj(ObjId id) { return (id < m_obj_list.size()) && m_obj_list[id]; }
+    inline pugi::xml_node getObj(ObjId id)
+    {
+        if (!isObj(id))
+            return {};
+        if ((id < m_obj_raw.size()) && !m_obj_raw[id].empty())
+            materializeObj(id);
+        return m_obj_list[id];
     }
-    inline void getObjList(std::vector<std::string>& out)
+    inline pugi::xml_node   getObj(std::string_view id) { return getObj(parseObjId(id)); }
+    inline std::string_view getObjName(ObjId id) { return isObj(id) ? m_obj_list[id].attribute("name").as_string() : ""; } // w/o parsing lazy objects
+    inline std::string_view getObjClass(ObjId id) { return isObj(id) ? m_obj_list[id].attribute("class").as_string() : ""; }
+    inline size_t           getObjCount() { return m_obj_count; }
+    inline pugi::xml_node   getFirstObjByClass(std::string_view hkclass)
     {
-        for (auto& pair : m_obj_list)
-            out.push_back(pair.first);
+        auto it = m_obj_class_list.find(hkclass);
+        return ((it == m_obj_class_list.end()) || it->second.empty()) ? pugi::xml_node{} : getObj(it->second.front());
+    }
+    inline void             getObjList(std::vector<std::string>& out)
+    {
+        for (auto obj : m_obj_list)
+            if (obj)
+                out.push_back(obj.attribute("name").as_string());
     }
     inline void getObjListByClass(std::string_view hkclass, std::vector<std::string>& out)
     {
         if (m_obj_class_list.contains(hkclass))
-            for (auto& id : m_obj_class_list.find(hkclass)->second)
-                out.push_back(id);
+            for (auto id : m_obj_class_list.find(hkclass)->second)
+                out.emplace_back(getObjName(id));
     }
     inline void getClasses(std::vector<std::string>& out)
     {
@@ -82,26 +210,130 @@ public:
         std::ranges::sort(out);
     }
 
-    std::string_view addObj(std::string_view hkclass);
-    void             delObj(std::string_view id);
-    void             reindexObj(uint16_t start_id = 100);
-
-    virtual bool isObjEssential(std::string_view id) { return m_root_obj == getObj(id); };
+    // big numeric hkparams (bone weights etc.) decoded once and edited in place
+    // edit widgets flush what they change right away, saving and the journal flush the rest as a fallback
+    template <typename T>
+    std::vector<T>& getNumericArray(pugi::xml_node hkparam)
+    {
+        auto& entry = m_numeric_arrays[hkparam.internal_object()];
+        if (!std::holds_alternative<std::vector<T>>(entry.values) || !entry.hkparam)
+        {
+            entry.obj       = getParentObj(hkparam);
+            entry.hkparam   = hkparam;
+            auto& values    = entry.values.template emplace<std::vector<T>>();
+            auto  num_elems = hkparam.attribute("numelements").as_ullong();
+            parsePayload(hkparam.text().as_string(), values, num_elems);
+            values.resize(num_elems);
+        }
+        entry.used = true;
+        return std::get<std::vector<T>>(entry.values);
+    }
+    void flushNumericArrays();                    // write back the ones used since the last call, forget the rest
+    void flushNumericArray(pugi::xml_node hkparam); // just this one, if it's there
+    void dropNumericArrays(pugi::xml_node obj);     // w/o writing, before the hkparams of obj get replaced
+
+    // whatever writes into an object reports it here, only these get journaled
+    void        markObjEdited(ObjId id);
+    inline void markEdited(pugi::xml_node node) { markObjEdited(parseObjId(getParentObj(node).attribute("name").as_string())); }
+    inline bool ownsNode(pugi::xml_node node) { return node.root() == m_doc; }
+
+    std::string_view   addObj(std::string_view hkclass);
+    void               delObj(std::string_view id);
+    size_t             delObjs(std::span<const ObjId> ids); // at once, keeps those still referenced from outside ids
+    size_t             delSubtree(ObjId id);                // id and everything below it nothing else references
+    std::vector<ObjId> getUnreachableObjs();                // from the root object
+    void               reindexObj(ObjId start_id = 100);
+
+    // by the shells in m_obj_list, so lazy objects don't get parsed just for this
+    virtual bool isObjEssential(ObjId id) { return isObj(id) && (m_root_obj == m_obj_list[id]); };
+    inline bool  isObjEssential(std::string_view id) { return isObjEssential(parseObjId(id)); }
 
 protected:
     bool m_loaded = false;
 
     std::string        m_path, m_filename;
-    pugi::xml_document m_doc;
+    // must outlive m_doc, which points into it. shared with background saves of unparsed objects
+    std::shared_ptr<MappedFile> m_mapped_file = std::make_shared<MappedFile>();
+    pugi::xml_document          m_doc;
     pugi::xml_node     m_data_node, m_root_obj;
-    uint16_t           m_latest_id = 0;
+    ObjId              m_latest_id = 0;
+
+    std::priority_queue<ObjId, std::vector<ObjId>, std::greater<>> m_free_ids; // deleted ids, reused lowest first
+
+    // all indexed by object id
+    std::vector<pugi::xml_node>        m_obj_list;
+    size_t                             m_obj_count = 0;
+    StringMap<std::vector<ObjId>>      m_obj_class_list;
+    std::vector<std::vector<ObjId>>    m_obj_ref_list;    // id -> objects it references, sorted
+    std::vector<std::vector<uint32_t>> m_obj_ref_count;   // id -> how many times each of m_obj_ref_list[id] is referenced
+    std::vector<std::vector<ObjId>>    m_obj_ref_by_list; // id -> objects referencing it
+
+    uint64_t m_graph_version     = 1; // bump with every change to the lists above
+    uint64_t m_ref_graph_version = 0;
+    RefGraph m_ref_graph;
+
+    uint64_t                                          m_state_index_version = 0;
+    std::vector<ObjId>                                m_owner_state_machine; // id -> getOwnerStateMachine(id)
+    robin_hood::unordered_node_map<ObjId, StateIdSet> m_state_ids;           // state machine -> its states, filled on demand
 
-    StringMap<pugi::xml_node>           m_obj_list;
-    StringMap<std::vector<std::string>> m_obj_class_list;
-    StringMap<StringSet>                m_obj_ref_list;
-    StringMap<StringSet>                m_obj_ref_by_list;
+    void updateStateIndex();
 
-    void reindexObjInternal(uint16_t start_id = 100); // reindex w/o logging & event
+    // lazy loading, id -> whole "<hkobject>...</hkobject>" text in the mapping, empty once parsed
+    // unparsed objects only have their attributes in m_doc
+    std::vector<std::string_view> m_obj_raw;
+    size_t                        m_lazy_obj_count = 0;
+
+    void         materializeObj(ObjId id);
+    virtual void onObjChanged(ObjId) {} // edited, added, deleted or just parsed, for indices of derived files
+    void materializeAll(); // before anything that has to see every object
+
+    // incremental saving, id -> hash of the object as it is in the file on disk (m_path), 0 if unknown
+    // unchanged objects are copied from the file instead of being serialized again
+    std::vector<uint64_t> m_obj_hash;
+    uint64_t              m_disk_size  = 0;
+    int64_t               m_disk_mtime = 0;
+
+    struct NumericArray
+    {
+        pugi::xml_node                                          obj, hkparam;
+        std::variant<std::vector<float>, std::vector<int16_t>> values;
+        bool                                                    used = false; // since the last flush
+    };
+    robin_hood::unordered_node_map<pugi::xml_node_struct*, NumericArray> m_numeric_arrays;
+
+    std::vector<uint64_t> hashObjs();                                // id -> hash of every parsed object, 0 for the rest
+    void                  recordObjHashes();                         // call when the document matches the file on disk
+    bool                  isDiskFileUnchanged(std::string_view path); // since the hashes were taken
+
+    struct SaveSnapshot;
+    std::shared_ptr<SaveSnapshot> m_save_snapshot;
+    std::future<bool>             m_save_result;
+
+    std::shared_ptr<SaveSnapshot> makeSaveSnapshot(const std::string& source_path);
+
+    // saveFile in two halves, so saving every file can snapshot them in parallel and only launch on this thread
+    friend class HkxFileManager;
+    void snapshotForSave(std::string_view path); // after beforeSave, touches nothing outside this file
+    void launchSave(bool async);
+
+    // crash recovery, objects changed since loading/saving are appended to <file>.journal every few seconds
+    // and replayed on the next load if the app didn't close cleanly
+    // id -> hash of the object as the journal has it, 0 if not in it or never parsed (then the file has it)
+    std::vector<uint64_t>                 m_journal_hash;
+    robin_hood::unordered_flat_set<ObjId> m_edited_ids;  // since the last journal write
+    robin_hood::unordered_flat_set<ObjId> m_unsaved_ids; // since the last save snapshot
+
+    inline std::string getJournalPath() { return m_path + ".journal"; }
+    void               replayJournal();
+
+    bool registerObj(ObjId id, pugi::xml_node obj); // bookkeeping of a node just put under m_data_node, removes it if the id is out of range
+    void unregisterObj(ObjId id);                   // and the reverse, also removes the node
+    void unlinkObj(ObjId id);                       // unregisterObj w/o touching m_obj_class_list
+
+    // append sorted valid refs of one object, safe to run in parallel
+    void scanObjRefs(ObjId id, std::vector<ObjId>& out);
+    // reindex w/o logging & event, ref_nodes are the pcdata containing refs if already known
+    void reindexObjInternal(ObjId start_id = 100, std::vector<pugi::xml_node>* ref_nodes = nullptr);
 };
 
 // Single behaviour file
@@ -110,18 +342,18 @@ class BehaviourFile : public HkxFile
 public:
     virtual constexpr HkxFileType getType() override { return kBehaviour; }
 
-    void         loadFile(std::string_view path);
-    virtual void saveFile(std::string_view path = {}) override;
+    void loadFile(std::string_view path, LoadMode mode = kLoadMapped);
 
     inline std::string_view getRootStateMachine()
     {
         return m_graph_obj.getByName("rootGenerator").text().as_string();
     }
 
-    inline virtual bool isObjEssential(std::string_view id) override
+    using HkxFile::isObjEssential;
+    inline virtual bool isObjEssential(ObjId id) override
     {
         auto essential_obj = {m_root_obj, m_graph_obj, m_graph_data_obj, m_graph_str_data_obj, m_var_value_obj};
-        return std::ranges::find(essential_obj, getObj(id)) != essential_obj.end();
+        return isObj(id) && (std::ranges::find(essential_obj, m_obj_list[id]) != essential_obj.end());
     }
 
     AnimationEventManager    m_evt_manager;
@@ -136,13 +368,47 @@ public:
     void reindexEvents();
     void reindexProps();
 
+    void markLinkedEdited(); // after adding/reindexing entries, they live in the graph data objects
+
     // removed unreferenced
     void cleanupVariables();
     void cleanupEvents();
     void cleanupProps();
 
+    // where each variable/event/property index is used
+    struct LinkedUsage
+    {
+        ObjId          obj;
+        pugi::xml_node hkparam; // the node holding the index, only safe right after an update. empty if obj was unparsed
+    };
+    void                         updateLinkedUsage(); // rescan objects changed since the last update, scans everything the first time
+    std::span<const LinkedUsage> getLinkedUsage(LinkedNodeType type, size_t idx) // as of the last update
+    {
+        return ((type != kLinkedNone) && (idx < m_linked_usage[type].size())) ? m_linked_usage[type][idx] : std::span<const LinkedUsage>{};
+    }
+
     pugi::xml_node m_graph_obj, m_graph_data_obj, m_graph_str_data_obj, m_var_value_obj; // Essential objects
 private:
+    using IndexRemap = robin_hood::unordered_map<size_t, size_t>;
+
+    void         remapLinkedNodes(const IndexRemap& var_remap, const IndexRemap& evt_remap, const IndexRemap& prop_remap);
+    void         reindexLinked(bool vars, bool evts, bool props); // marks the graph data edited only if something moved
+
+    pugi::xml_node getFirstLinkedRef(LinkedNodeType type, size_t idx, bool ret_obj);
+
+    // usage index, built on first use then objects are rescanned as they get reported through onObjChanged
+    bool                                                        m_linked_usage_built = false;
+    robin_hood::unordered_flat_set<ObjId>                       m_linked_usage_stale;
+    std::vector<std::vector<std::pair<LinkedNodeType, size_t>>> m_obj_linked_usage; // id -> what it was filed under in m_linked_usage
+    std::array<std::vector<std::vector<LinkedUsage>>, 4>        m_linked_usage;     // type -> index -> sites
+
+    void         scanLinkedUsage(ObjId id); // replaces whatever id had in the index
+    virtual void onObjChanged(ObjId id) override
+    {
+        if (m_linked_usage_built)
+            m_linked_usage_stale.insert(id);
+    }
+    virtual void beforeSave() override;
 };
 
 // skeleton hkx
@@ -151,7 +417,7 @@ class SkeletonFile : public HkxFile
 public:
     virtual constexpr HkxFileType getType() override { return kSkeleton; }
 
-    void loadFile(std::string_view path);
+    void loadFile(std::string_view path, LoadMode mode = kLoadMapped);
 
     inline pugi::xml_node   getBoneNode(bool ragdoll = false) { return (ragdoll ? m_skel_rag_obj : m_skel_obj).getByName("bones"); }
     void                    getBoneList(std::vector<std::string_view>& out, bool ragdoll = false);
@@ -160,7 +426,8 @@ public:
         return getNthChild(ragdoll ? m_skel_rag_obj.getByName("bones") : m_skel_obj.getByName("bones"), idx).getByName("name").text().as_string();
     }
 
-    inline virtual bool isObjEssential(std::string_view) override { return true; }
+    using HkxFile::isObjEssential;
+    inline virtual bool isObjEssential(ObjId) override { return true; }
 
 private:
     pugi::xml_node m_skel_obj, m_skel_rag_obj;
@@ -172,21 +439,25 @@ class CharacterFile : public HkxFile
 public:
     virtual constexpr HkxFileType getType() override { return kCharacter; }
 
-    void         loadFile(std::string_view path);
-    virtual void saveFile(std::string_view path = {}) override;
+    void loadFile(std::string_view path, LoadMode mode = kLoadMapped);
 
-    inline virtual bool isObjEssential(std::string_view id) override
+    using HkxFile::isObjEssential;
+    inline virtual bool isObjEssential(ObjId id) override
     {
         auto essential_obj = {/*m_root_obj, m_graph_obj,*/ m_char_data_obj, m_char_str_data_obj, m_var_value_obj};
-        return std::ranges::find(essential_obj, getObj(id)) != essential_obj.end();
+        return isObj(id) && (std::ranges::find(essential_obj, m_obj_list[id]) != essential_obj.end());
     }
 
     inline pugi::xml_node getAnimNames() { return m_anim_name_node; }
 
+    void markLinkedEdited(); // same as BehaviourFile's
+
     VariableManager m_prop_manager; // naming a bit confusing but charprops are essentially variables in character files
 private:
     pugi::xml_node m_anim_name_node;
     pugi::xml_node m_char_data_obj, m_char_str_data_obj, m_var_value_obj;
+
+    virtual void beforeSave() override;
 };
 
 // Managing files
@@ -210,11 +481,16 @@ public:
 
     void        loadFile(std::string_view path);
     void        saveFile(std::string_view path = {});
+    void        saveAllFiles(); // every loaded file with changes, at once
+    void        loadProject(std::string_view dir); // load behaviours, character and skeleton of a project folder in the background
+    void        update();                          // publish finished background loads, call every frame
+    void        markEdited(pugi::xml_node node);   // for the file node belongs to
     inline void closeCurrentFile()
     {
         if (m_current_file && m_current_file->getType() == HkxFile::kBehaviour)
         {
             auto idx = std::ranges::find_if(m_files, [=](auto& item) { return &item == m_current_file; }) - m_files.begin();
+            m_files[idx].discardJournal();
             m_files.erase(m_files.begin() + idx);
             m_current_file = m_files.empty() ? nullptr : &m_files[std::clamp(idx, (int64_t)0, (int64_t)m_files.size() - 1)];
             dispatch(kEventFileChanged);
@@ -222,17 +498,46 @@ public:
     }
     inline void closeAllFiles()
     {
+        for (auto& file : m_files)
+            file.discardJournal();
         m_current_file = nullptr;
         m_files.clear();
         dispatch(kEventFileChanged);
     }
+    void discardJournals(); // app closing normally
+
+    enum LoadState
+    {
+        kLoadQueued,
+        kLoadLoading,
+        kLoadDone,
+        kLoadFailed
+    };
+    struct LoadJob
+    {
+        std::string              path;
+        HkxFile::HkxFileType     type;
+        std::shared_ptr<HkxFile> file; // shared_ptr for the type-erased deleter
+        std::atomic<LoadState>   state     = kLoadQueued;
+        bool                     published = false;
+    };
+    inline bool                                         isLoadingProject() { return !m_load_jobs.empty(); }
+    inline const std::vector<std::unique_ptr<LoadJob>>& getLoadJobs() { return m_load_jobs; }
 
     SkeletonFile  m_skel_file;
     CharacterFile m_char_file;
 
+    bool m_lazy_load = false; // load behaviours with kLoadLazy
+    bool m_short_ids = false; // never go past #9999, for tools that expect 4 digit ids
+
 private:
-    HkxFile*                   m_current_file = nullptr;
-    std::vector<BehaviourFile> m_files;
+    HkxFile*                  m_current_file = nullptr;
+    std::deque<BehaviourFile> m_files; // deque so pushing new files won't move the opened ones
+
+    std::chrono::steady_clock::time_point m_last_journal_write;
+
+    std::vector<std::unique_ptr<LoadJob>> m_load_jobs;
+    std::jthread                          m_load_thread; // last member, joined before the jobs go away
 };
 
 } // namespace Hkx
@@ -0,0 +1,103 @@
+#include "indexcache.h"
+
+#include <array>
+#include <fstream>
+
+namespace Haviour
+{
+namespace Hkx
+{
+namespace
+{
+constexpr std::array<char, 8> g_magic = {'H', 'V', 'I', 'D', 'X', '\0', '\0', '\0'};
+
+template <typename T>
+void writePod(std::ofstream& stream, const T& val) { stream.write(reinterpret_cast<const char*>(&val), sizeof(T)); }
+template <typename T>
+bool readPod(std::ifstream& stream, T& val) { return bool(stream.read(reinterpret_cast<char*>(&val), sizeof(T))); }
+
+// don't trust counts from a possibly truncated/garbage file with huge allocations
+constexpr uint32_t g_max_count = 1 << 24;
+} // namespace
+
+bool IndexCache::read(std::string_view path)
+{
+    std::ifstream stream(getCachePath(path), std::ios::binary);
+    if (!stream)
+        return false;
+
+    std::array<char, 8> magic;
+    uint32_t            version;
+    if (!(readPod(stream, magic) && readPod(stream, version)) || (magic != g_magic) || (version != g_version))
+        return false;
+
+    uint32_t num_classes, num_objs;
+    if (!(readPod(stream, file_size) && readPod(stream, mtime) && readPod(stream, hash) &&
+          readPod(stream, num_classes) && readPod(stream, num_objs)) ||
+        (num_classes > g_max_count) || (num_objs > g_max_count))
+        return false;
+
+    classes.resize(num_classes);
+    for (auto& hkclass : classes)
+    {
+        uint32_t len;
+        if (!readPod(stream, len) || (len > 1024))
+            return false;
+        hkclass.resize(len);
+        if (!stream.read(hkclass.data(), len))
+            return false;
+    }
+
+    objects.resize(num_objs);
+    if (!stream.read(reinterpret_cast<char*>(objects.data()), num_objs * sizeof(Object)))
+        return false;
+    for (auto& obj : objects)
+        if (obj.class_idx >= num_classes)
+            return false;
+
+    refs.resize(num_objs);
+    for (auto& obj_refs : refs)
+    {
+        uint32_t num_refs;
+        if (!readPod(stream, num_refs) || (num_refs > g_max_count))
+            return false;
+        obj_refs.resize(num_refs);
+        if (!stream.read(reinterpret_cast<char*>(obj_refs.data()), num_refs * sizeof(uint32_t)))
+            return false;
+    }
+
+    return true;
+}
+
+bool IndexCache::write(std::string_view path) const
+{
+    std::ofstream stream(getCachePath(path), std::ios::binary | std::ios::trunc);
+    if (!stream)
+        return false;
+
+    writePod(stream, g_magic);
+    writePod(stream, g_version);
+    writePod(stream, file_size);
+    writePod(stream, mtime);
+    writePod(stream, hash);
+    writePod(stream, (uint32_t)classes.size());
+    writePod(stream, (uint32_t)objects.size());
+
+    for (auto& hkclass : classes)
+    {
+        writePod(stream, (uint32_t)hkclass.size());
+        stream.write(hkclass.data(), hkclass.size());
+    }
+
+    stream.write(reinterpret_cast<const char*>(objects.data()), objects.size() * sizeof(Object));
+
+    for (auto& obj_refs : refs)
+    {
+        writePod(stream, (uint32_t)obj_refs.size());
+        stream.write(reinterpret_cast<const char*>(obj_refs.data()), obj_refs.size() * sizeof(uint32_t));
+    }
+
+    return bool(stream);
+}
+} // namespace Hkx
+} // namespace Haviour
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Haviour
+{
+namespace Hkx
+{
+// Sidecar written next to an opened hkx so reopening it can skip scanning for references
+// Only valid for the exact bytes it was built from (size + mtime + content hash)
+struct IndexCache
+{
+    static constexpr uint32_t g_version = 3; // bump when the ref param table changes
+
+    struct Object
+    {
+        uint32_t id;
+        uint32_t class_idx;
+        uint64_t offset; // byte offset of the hkobject in the file
+    };
+
+    uint64_t file_size = 0;
+    int64_t  mtime     = 0;
+    uint64_t hash      = 0;
+
+    std::vector<std::string>           classes;
+    std::vector<Object>                objects;
+    std::vector<std::vector<uint32_t>> refs; // per object (same order as objects), ids it references, repeated per reference
+
+    static std::string getCachePath(std::string_view path) { return std::string(path) + ".hvidx"; }
+
+    bool read(std::string_view path);
+    bool write(std::string_view path) const;
+    bool matches(uint64_t size, int64_t time, uint64_t content_hash) const { return (file_size == size) && (mtime == time) && (hash == content_hash); }
+};
+} // namespace Hkx
+} // namespace Haviour
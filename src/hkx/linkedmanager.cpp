@@ -3,7 +3,6 @@
 #include "linkedmanager.h"
 #include "hkclass.inl"
 
-#include <sstream>
 #include <fmt/format.h>
 
 namespace Haviour
@@ -23,27 +22,19 @@ void VariableManager::buildEntryList(pugi::xml_node name_node, pugi::xml_node in
 {
     LinkedPropertyManager<Variable>::buildEntryList({name_node, info_node, value_node});
     // get quads
-    m_quad_node            = quad_node;
-    auto        quad_count = quad_node.attribute("numelements").as_uint();
-    std::string quad_vals  = quad_node.text().as_string();
-    std::erase_if(quad_vals, [](char& a) { return (a == '(') || (a == ')'); });
-    std::istringstream quad_stream(quad_vals);
+    m_quad_node                   = quad_node;
+    auto               quad_count = quad_node.attribute("numelements").as_uint();
+    std::vector<float> quad_vals;
+    quad_vals.reserve(quad_count * 4);
+    parsePayload(quad_node.text().as_string(), quad_vals, quad_count * 4);
+    quad_vals.resize(quad_count * 4);
     for (size_t i = 0; i < quad_count; i++)
-    {
-        m_quads.push_back({});
-        auto& array = m_quads.back();
-        quad_stream >> array[0] >> array[1] >> array[2] >> array[3];
-    }
+        m_quads.push_back({quad_vals[i * 4], quad_vals[i * 4 + 1], quad_vals[i * 4 + 2], quad_vals[i * 4 + 3]});
     // get pointers
-    m_ptr_node                   = ptr_node;
-    auto               ptr_count = ptr_node.attribute("numelements").as_uint();
-    std::string        ptr_vals  = ptr_node.text().as_string();
-    std::istringstream ptr_stream(ptr_vals);
-    for (size_t i = 0; i < ptr_count; i++)
-    {
-        m_ptrs.push_back({});
-        ptr_stream >> m_ptrs.back();
-    }
+    m_ptr_node     = ptr_node;
+    auto ptr_count = ptr_node.attribute("numelements").as_uint();
+    parsePayload(ptr_node.text().as_string(), m_ptrs, ptr_count);
+    m_ptrs.resize(ptr_count);
 }
 
 Variable VariableManager::addEntry(VariableTypeEnum data_type)
@@ -6,6 +6,7 @@
 #pragma once
 #include "utils.h"
 
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <tuple>
@@ -105,22 +106,37 @@ public:
             return {};
     }
     inline std::vector<T> getEntryList() { return m_entries; }
-    inline T              getEntryByName(std::string_view name)
+    // case insensitive, first valid one if names repeat
+    inline T getEntryByName(std::string_view name)
     {
-        auto res = std::ranges::find_if(m_entries, [=](auto& entry) { return !_stricmp(name.data(), entry.getName()); });
-        if (res == m_entries.end())
+        auto it = m_name_index.find(name);
+        if (it == m_name_index.end())
             return {};
         else
-            return *res;
+            return m_entries[it->second.front()];
     }
     inline T addEntry()
     {
         auto retval    = T::create(m_container_nodes);
         retval.m_index = m_entries.size();
         m_entries.push_back(retval);
+        m_indexed_names.emplace_back();
+        indexName(retval.m_index);
         return retval;
     }
-    inline void delEntry(size_t idx) { m_entries[idx].m_valid = false; }
+    inline void delEntry(size_t idx)
+    {
+        unindexName(idx);
+        m_entries[idx].m_valid = false;
+    }
+    // call after the name of idx might have been edited, does nothing if it wasn't
+    inline void updateEntryName(size_t idx)
+    {
+        if ((idx >= m_entries.size()) || !m_entries[idx].m_valid || (m_indexed_names[idx] == m_entries[idx].getName()))
+            return;
+        unindexName(idx);
+        indexName(idx);
+    }
 
     // clean up deleted variable
     // returns a idx remap map
@@ -147,6 +163,7 @@ public:
         for (size_t i = 0; i < m_container_nodes.size(); ++i)
             m_container_nodes[i].attribute("numelements") = size();
 
+        rebuildNameIndex();
         return remap;
     }
 
@@ -154,6 +171,34 @@ protected:
     T::NodeArray   m_container_nodes;
     std::vector<T> m_entries = {};
 
+    // name -> indices of valid entries with it, ascending
+    StringMapNoCase<std::vector<size_t>> m_name_index;
+    std::vector<std::string>             m_indexed_names; // idx -> name it is under in m_name_index
+
+    void indexName(size_t idx)
+    {
+        m_indexed_names[idx] = m_entries[idx].getName();
+        auto& indices        = m_name_index[m_indexed_names[idx]];
+        indices.insert(std::ranges::upper_bound(indices, idx), idx);
+    }
+    void unindexName(size_t idx)
+    {
+        auto it = m_name_index.find(m_indexed_names[idx]);
+        if (it == m_name_index.end())
+            return;
+        std::erase(it->second, idx);
+        if (it->second.empty())
+            m_name_index.erase(it);
+    }
+    void rebuildNameIndex()
+    {
+        m_name_index.clear();
+        m_indexed_names.assign(m_entries.size(), {});
+        for (size_t i = 0; i < m_entries.size(); ++i)
+            if (m_entries[i].m_valid)
+                indexName(i);
+    }
+
     void buildEntryList(const typename T::NodeArray& container_nodes)
     {
         m_entries.clear();
@@ -172,6 +217,7 @@ protected:
             for (size_t j = 0; j < container_nodes.size(); ++j)
                 nodes[j] = nodes[j].next_sibling();
         }
+        rebuildNameIndex();
     }
 };
 
@@ -0,0 +1,134 @@
+#include "mappedfile.h"
+
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    include <Windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace Haviour
+{
+namespace Hkx
+{
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+bool MappedFile::open(std::string_view path)
+{
+    close();
+
+    std::string path_str(path);
+#ifdef _WIN32
+    // share delete so the file can still be renamed away when saving over it
+    auto file = CreateFileA(path_str.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || !file_size.QuadPart)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    auto mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    auto view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping); // the view keeps the mapping alive
+    if (!view)
+        return false;
+
+    m_data = static_cast<char*>(view);
+    m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = ::open(path_str.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) || !file_stat.st_size)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    auto view = mmap(nullptr, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<char*>(view);
+    m_size = static_cast<size_t>(file_stat.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!m_data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+#else
+    munmap(m_data, m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool replaceFile(const std::filesystem::path& src, const std::filesystem::path& dst)
+{
+#ifdef _WIN32
+    // works on mapped files too as long as they were opened with share delete
+    if (MoveFileExW(src.c_str(), dst.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        return true;
+#endif
+    std::error_code ec;
+    std::filesystem::rename(src, dst, ec);
+    if (!ec)
+        return true;
+
+    // dst is probably mapped somewhere, move it out of the way and let it die when unmapped
+    auto old_path = dst;
+    old_path += ".old";
+    std::filesystem::remove(old_path, ec); // leftover of an earlier save, may still be mapped
+    std::filesystem::rename(dst, old_path, ec);
+    if (ec)
+        return false;
+
+    std::filesystem::rename(src, dst, ec);
+    if (ec)
+    {
+        // put the original back, src stays for the user to recover
+        std::error_code restore_ec;
+        std::filesystem::rename(old_path, dst, restore_ec);
+        return false;
+    }
+    std::filesystem::remove(old_path, ec); // fails while still mapped, the next save retries
+    return true;
+}
+} // namespace Hkx
+} // namespace Haviour
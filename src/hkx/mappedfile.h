@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string_view>
+#include <filesystem>
+
+namespace Haviour
+{
+namespace Hkx
+{
+// Copy-on-write view of a file on disk
+// Pages are private to the process, so the buffer can be parsed/modified in place without touching the file
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(std::string_view path);
+    void close();
+
+    inline bool   isOpen() const { return m_data; }
+    inline char*  data() { return m_data; }
+    inline size_t size() const { return m_size; }
+    inline bool   contains(const void* ptr) const { return m_data && (ptr >= m_data) && (ptr < m_data + m_size); }
+
+private:
+    char*  m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// Move src over dst, even if dst is currently mapped (windows refuses to overwrite mapped files)
+bool replaceFile(const std::filesystem::path& src, const std::filesystem::path& dst);
+} // namespace Hkx
+} // namespace Haviour
@@ -3,34 +3,38 @@
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
-#include <spdlog/details/null_mutex.h>
 #include <imgui.h>
 #include <extern/imgui_notify.h>
 
+#include <mutex>
+#include <vector>
+
 namespace Haviour
 {
+// imgui isn't thread safe, so toasts are queued here and handed over on the main thread
+std::mutex              g_notify_mutex;
+std::vector<ImGuiToast> g_notify_queue;
+
 template <typename Mutex>
 class notify_sink : public spdlog::sinks::base_sink<Mutex>
 {
 protected:
     void sink_it_(const spdlog::details::log_msg& msg) override
     {
-        if (!ImGui::GetCurrentContext())
-            return;
-
         std::string str(msg.payload.begin(), msg.payload.end());
 
+        std::lock_guard lock(g_notify_mutex);
         switch (msg.level)
         {
             case spdlog::level::info:
-                ImGui::InsertNotification({ImGuiToastType_Info, 5000, str.c_str()});
+                g_notify_queue.push_back({ImGuiToastType_Info, 5000, str.c_str()});
                 break;
             case spdlog::level::warn:
-                ImGui::InsertNotification({ImGuiToastType_Warning, 5000, str.c_str()});
+                g_notify_queue.push_back({ImGuiToastType_Warning, 5000, str.c_str()});
                 break;
             case spdlog::level::err:
             case spdlog::level::critical:
-                ImGui::InsertNotification({ImGuiToastType_Error, 8000, str.c_str()});
+                g_notify_queue.push_back({ImGuiToastType_Error, 8000, str.c_str()});
                 break;
             default:
                 break;
@@ -40,6 +44,17 @@ protected:
     void flush_() override {}
 };
 
+void flushNotifications()
+{
+    if (!ImGui::GetCurrentContext())
+        return;
+
+    std::lock_guard lock(g_notify_mutex);
+    for (auto& toast : g_notify_queue)
+        ImGui::InsertNotification(toast);
+    g_notify_queue.clear();
+}
+
 void setupLogger()
 {
     auto max_size  = (1 << 20) * 10;
@@ -50,7 +65,7 @@ void setupLogger()
     logger->flush_on(spdlog::level::debug);
     logger->set_pattern("[%H:%M:%S:%e] [%n] [%l] %v");
 
-    logger->sinks().push_back(std::make_shared<notify_sink<spdlog::details::null_mutex>>());
+    logger->sinks().push_back(std::make_shared<notify_sink<std::mutex>>());
     logger->sinks().push_back(std::make_shared<spdlog::sinks::stderr_color_sink_mt>());
 
     spdlog::set_default_logger(logger);
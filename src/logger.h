@@ -6,4 +6,5 @@
 namespace Haviour
 {
 void setupLogger();
+void flushNotifications(); // show log toasts queued from any thread
 } // namespace Haviour
@@ -87,7 +87,10 @@ UICLASS(hkbStateMachineEventPropertyArray)
         ImGui::AlignTextToFramePadding();
         ImGui::BulletText("events"), ImGui::SameLine();
         if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
+        {
             appendXmlString(events_node, Hkx::g_def_hkbEvent);
+            file.markEdited(obj);
+        }
         addTooltip("Add new event");
         ImGui::SameLine();
         ImGui::AlignTextToFramePadding();
@@ -121,6 +124,7 @@ UICLASS(hkbStateMachineEventPropertyArray)
             {
                 events_node.remove_child(mark_delete);
                 events_node.attribute("numelements") = events_node.attribute("numelements").as_int() - 1;
+                file.markEdited(obj);
             }
 
             ImGui::EndTable();
@@ -247,7 +251,10 @@ void BSLookAtModifierBoneArray(pugi::xml_node hkparam, Hkx::BehaviourFile& file)
     ImGui::AlignTextToFramePadding();
     ImGui::BulletText(hkparam.attribute("name").as_string()), ImGui::SameLine();
     if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
+    {
         appendXmlString(hkparam, Hkx::g_def_BSLookAtModifier_Bone);
+        file.markEdited(hkparam);
+    }
     addTooltip("Add new event");
     ImGui::SameLine();
     ImGui::AlignTextToFramePadding();
@@ -300,6 +307,7 @@ void BSLookAtModifierBoneArray(pugi::xml_node hkparam, Hkx::BehaviourFile& file)
         {
             hkparam.remove_child(mark_delete);
             hkparam.attribute("numelements") = hkparam.attribute("numelements").as_int() - 1;
+            file.markEdited(hkparam);
         }
 
         ImGui::EndTable();
@@ -493,7 +501,10 @@ UICLASS(hkbStateMachineStateInfo)
         {
             StringEdit(obj.getByName("name"), file)();
             RefEdit<Hkx::g_class_binding>(obj.getByName("variableBindingSet"), file)();
+            auto state_id = obj.getByName("stateId").text().as_int();
             ScalarEdit<ImGuiDataType_S32>(obj.getByName("stateId"), file)();
+            if (obj.getByName("stateId").text().as_int() != state_id)
+                file.invalidateStateIds();
             SliderScalarEdit(obj.getByName("probability"), file,
                              "The state probability.  When choosing a random start state, each state is weighted according to its probability.\n"
                              "The probabilities of all of the states being considered are normalized so that their sum is 1.\n"
@@ -564,7 +575,10 @@ UICLASS(hkbStateMachineTransitionInfoArray)
         ImGui::AlignTextToFramePadding();
         ImGui::TextUnformatted("transitions"), ImGui::SameLine();
         if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
+        {
             appendXmlString(transitions_node, Hkx::g_def_hkbStateMachine_TransitionInfo);
+            file.markEdited(obj);
+        }
         addTooltip("Add new transition");
         ImGui::SameLine();
         ImGui::AlignTextToFramePadding();
@@ -609,6 +623,7 @@ UICLASS(hkbStateMachineTransitionInfoArray)
                     edit_trans = {};
                 transitions_node.remove_child(mark_delete);
                 transitions_node.attribute("numelements") = transitions_node.attribute("numelements").as_int() - 1;
+                file.markEdited(obj);
             }
 
             ImGui::EndTable();
@@ -809,38 +824,77 @@ UICLASS(hkbBoneWeightArray)
 
     ImGui::PushID("boneWeights");
 
-    auto               bone_weights_obj = obj.getByName("boneWeights");
-    std::istringstream bone_weights_stream(bone_weights_obj.text().as_string());
-    auto               num_weights = bone_weights_obj.attribute("numelements").as_ullong();
-    std::vector<float> bone_weights(num_weights);
-    for (size_t i = 0; i < num_weights; ++i)
-        bone_weights_stream >> bone_weights[i];
+    auto  bone_weights_obj = obj.getByName("boneWeights");
+    auto& bone_weights     = file.getNumericArray<float>(bone_weights_obj);
+    bool  edited           = false; // written back right away, not left to the next flush
 
     ImGui::TextUnformatted("boneWeights");
     addTooltip("A weight for each bone.\nIf the list is too short, missing bones are assumed to have weight 1.");
     ImGui::SameLine();
     if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
+    {
         bone_weights.push_back(0.0f);
+        edited = true;
+    }
     addTooltip("Add item");
     ImGui::SameLine();
     if (ImGui::Button(ICON_FA_MINUS_CIRCLE) && !bone_weights.empty())
+    {
         bone_weights.pop_back();
+        edited = true;
+    }
     addTooltip("Remove item");
     ImGui::SameLine();
-    ImGui::Text("%d", num_weights);
+    ImGui::Text("%zu", bone_weights.size());
+
+    // bulk edits
+    static float bulk_value = 1.0f;
+    ImGui::SetNextItemWidth(80.0f);
+    ImGui::InputFloat("##bulk", &bulk_value, 0.0f, 0.0f, "%.3f");
+    ImGui::SameLine();
+    if (ImGui::Button("Set All"))
+    {
+        std::ranges::fill(bone_weights, bulk_value);
+        edited = true;
+    }
+    addTooltip("Set every weight to the value");
+    ImGui::SameLine();
+    if (ImGui::Button("Scale"))
+    {
+        for (auto& weight : bone_weights)
+            weight *= bulk_value;
+        edited = true;
+    }
+    addTooltip("Multiply every weight by the value");
+    ImGui::SameLine();
+    if (ImGui::Button("Copy From"))
+        ImGui::OpenPopup("copyfrom");
+    addTooltip("Copy all weights from another bone weight array");
+    if (ImGui::BeginPopup("copyfrom"))
+    {
+        std::vector<std::string> weight_arrays;
+        file.getObjListByClass("hkbBoneWeightArray", weight_arrays);
+        for (auto& id : weight_arrays)
+            if (auto other = file.getObj(id); (other != obj) && ImGui::Selectable(id.c_str()))
+            {
+                bone_weights = file.getNumericArray<float>(other.getByName("boneWeights"));
+                edited       = true;
+            }
+        ImGui::EndPopup();
+    }
 
     if (ImGui::BeginTable("hkbBoneWeightArray2", 4, ImGuiTableFlags_SizingStretchSame | ImGuiTableFlags_ScrollY))
     {
         for (size_t i = 0; i < bone_weights.size(); ++i)
         {
             ImGui::TableNextColumn();
-            ImGui::InputFloat(fmt::format("{}", i).c_str(), &bone_weights[i], 0.0f, 0.0f, "%.6f");
+            if (ImGui::InputFloat(fmt::format("{}", i).c_str(), &bone_weights[i], 0.0f, 0.0f, "%.6f"))
+                edited = true;
         }
         ImGui::EndTable();
     }
-
-    bone_weights_obj.text()                   = printVector(bone_weights).c_str();
-    bone_weights_obj.attribute("numelements") = bone_weights.size();
+    if (edited)
+        file.flushNumericArray(bone_weights_obj);
 
     ImGui::PopID();
 }
@@ -856,14 +910,22 @@ UICLASS(hkbBoneIndexArray)
         ImGui::TableNextColumn();
         size_t numelements = bone_indices.attribute("numelements").as_ullong();
         if (ImGui::InputScalar("numelements", ImGuiDataType_U64, &numelements))
+        {
             bone_indices.attribute("numelements") = numelements;
+            file.dropNumericArrays(obj);
+            file.markEdited(obj);
+        }
 
         ImGui::TableNextColumn();
 
         ImGui::TableNextColumn();
         std::string value = bone_indices.text().as_string();
         if (ImGui::InputTextMultiline(bone_indices.attribute("name").as_string(), &value))
+        {
             bone_indices.text() = value.c_str();
+            file.dropNumericArrays(obj);
+            file.markEdited(obj);
+        }
 
         ImGui::TableNextColumn();
 
@@ -873,26 +935,29 @@ UICLASS(hkbBoneIndexArray)
 
     ImGui::PushID("boneIndices");
 
-    auto&                skel_file    = Hkx::HkxFileManager::getSingleton()->m_skel_file;
-    auto                 bone_idx_obj = obj.getByName("boneIndices");
-    std::istringstream   bone_idx_stream(bone_idx_obj.text().as_string());
-    auto                 num_idxs = bone_idx_obj.attribute("numelements").as_ullong();
-    std::vector<int16_t> bone_idxs(num_idxs);
-    for (size_t i = 0; i < num_idxs; ++i)
-        bone_idx_stream >> bone_idxs[i];
+    auto& skel_file    = Hkx::HkxFileManager::getSingleton()->m_skel_file;
+    auto  bone_idx_obj = obj.getByName("boneIndices");
+    auto& bone_idxs    = file.getNumericArray<int16_t>(bone_idx_obj);
+    bool  edited       = false; // written back right away, the raw text above shows it
 
     ImGui::TextUnformatted("boneIndices");
     addTooltip("An array of bone indices.");
     ImGui::SameLine();
     if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
+    {
         bone_idxs.push_back(-1);
+        edited = true;
+    }
     addTooltip("Add item");
     ImGui::SameLine();
     if (ImGui::Button(ICON_FA_MINUS_CIRCLE) && !bone_idxs.empty())
+    {
         bone_idxs.pop_back();
+        edited = true;
+    }
     addTooltip("Remove item");
     ImGui::SameLine();
-    ImGui::Text("%d", num_idxs);
+    ImGui::Text("%zu", bone_idxs.size());
 
     if (ImGui::BeginTable("hkbBoneIndexArray2", 8, ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_ScrollY))
     {
@@ -900,17 +965,20 @@ UICLASS(hkbBoneIndexArray)
         {
             ImGui::PushID(i);
             ImGui::TableNextColumn();
-            ImGui::InputScalar(fmt::format("{}", i).c_str(), ImGuiDataType_S16, &bone_idxs[i]);
+            if (ImGui::InputScalar(fmt::format("{}", i).c_str(), ImGuiDataType_S16, &bone_idxs[i]))
+                edited = true;
             ImGui::TableNextColumn();
             if (auto res = bonePickerButton("picker", skel_file, bone_idxs[i]); res.has_value())
+            {
                 bone_idxs[i] = res.value();
+                edited       = true;
+            }
             ImGui::PopID();
         }
         ImGui::EndTable();
     }
-
-    bone_idx_obj.text()                   = printVector(bone_idxs).c_str();
-    bone_idx_obj.attribute("numelements") = bone_idxs.size();
+    if (edited)
+        file.flushNumericArray(bone_idx_obj);
 
     ImGui::PopID();
 }
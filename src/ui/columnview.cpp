@@ -146,11 +146,9 @@ void ColumnView::showColumns()
 
                         items.back().push_back({"> " + disp_name, i});
 
-                        std::vector<std::string> reflist = {};
-                        file.getRefedObjs(item.id, reflist);
-                        for (auto& ref : reflist)
-                            if (m_class_show.contains(file.getObj(ref).attribute("class").as_string()))
-                                items.back().push_back({ref, i});
+                        for (auto ref : file.getRefedObjs(Hkx::parseObjId(item.id)))
+                            if (auto ref_obj = file.getObj(ref); m_class_show.contains(ref_obj.attribute("class").as_string()))
+                                items.back().push_back({ref_obj.attribute("name").as_string(), i});
                     }
                 }
             }
@@ -278,25 +276,12 @@ void ColumnView::expandChildren(std::string_view obj, size_t col)
     auto  file_manager = Hkx::HkxFileManager::getSingleton();
     auto& file         = *dynamic_cast<Hkx::BehaviourFile*>(file_manager->getCurrentFile());
 
-    StringSet                                  visited    = {};
-    std::deque<std::pair<std::string, size_t>> need_check = {{obj.data(), col}};
-    while (!need_check.empty())
-    {
-        auto& curr_pair = need_check.front();
-        if (curr_pair.second >= m_columns.size())
+    file.getRefGraph().walk(Hkx::parseObjId(obj), false, [&](Hkx::ObjId id, uint32_t depth) {
+        while (col + depth >= m_columns.size())
             m_columns.push_back({});
-
-        visited.insert(curr_pair.first);
-        m_columns[curr_pair.second].m_selected.insert(curr_pair.first);
-
-        std::vector<std::string> children;
-        file.getRefedObjs(curr_pair.first, children);
-        for (auto& child : children)
-            if (!visited.contains(child))
-                need_check.push_back({child, curr_pair.second + 1});
-
-        need_check.pop_front();
-    }
+        m_columns[col + depth].m_selected.insert(std::string(file.getObjName(id)));
+        return true;
+    });
 }
 
 } // namespace Ui
@@ -126,7 +126,7 @@ void ListView::updateCache(bool sort_only)
             if (m_do_filter_id)
                 std::erase_if(m_cache_list, [&](const std::string& id) {
                     return std::ranges::search(
-                               std::string_view(hkxfile.getObj(id).attribute("name").as_string()),
+                               std::string_view(id),
                                m_filter,
                                [](char ch1, char ch2) { return std::toupper(ch1) == std::toupper(ch2); })
                         .empty();
@@ -146,21 +146,21 @@ void ListView::updateCache(bool sort_only)
             [&](const std::string& a_str, const std::string& b_str) {
                 for (int n = 0; n < m_current_sort_spec.SpecsCount; n++)
                 {
-                    auto a = hkxfile.getObj(a_str);
-                    auto b = hkxfile.getObj(b_str);
-
                     const auto sort_spec = m_current_sort_spec.Specs[n];
                     int        delta     = 0;
                     switch (sort_spec.ColumnUserID)
                     {
-                        case kColId:
-                            delta = strcmp(a.attribute("name").as_string(), b.attribute("name").as_string());
+                        case kColId: // numerically, ids can be longer than 4 digits
+                        {
+                            auto a_id = Hkx::parseObjId(a_str), b_id = Hkx::parseObjId(b_str);
+                            delta     = (a_id > b_id) - (a_id < b_id);
                             break;
+                        }
                         case kColName:
-                            delta = strcmp(getObjContextName(a), getObjContextName(b));
+                            delta = strcmp(getObjContextName(hkxfile.getObj(a_str)), getObjContextName(hkxfile.getObj(b_str)));
                             break;
                         case kColClass:
-                            delta = strcmp(a.attribute("class").as_string(), b.attribute("class").as_string());
+                            delta = strcmp(hkxfile.getObj(a_str).attribute("class").as_string(), hkxfile.getObj(b_str).attribute("class").as_string());
                             break;
                         default:
                             break;
@@ -199,7 +199,7 @@ void ListView::drawTable()
                 sorts_specs->SpecsDirty = false;
             }
 
-        std::string_view marked_delete = {};
+        std::string_view marked_delete = {}, marked_delete_subtree = {};
         ImGuiListClipper clipper;
         clipper.Begin(m_cache_list.size());
         while (clipper.Step())
@@ -219,6 +219,10 @@ void ListView::drawTable()
                 if (ImGui::Button(ICON_FA_TRASH)) // Delete
                     marked_delete = id;
                 addTooltip("Delete");
+                ImGui::SameLine();
+                if (ImGui::Button(ICON_FA_SITEMAP)) // Delete w/ children
+                    marked_delete_subtree = id;
+                addTooltip("Delete with children\nAlso deletes every object below it that nothing else references.");
                 ImGui::TableNextColumn();
                 copyableText(id.data());
                 ImGui::TableNextColumn();
@@ -230,6 +234,8 @@ void ListView::drawTable()
 
         if (!marked_delete.empty())
             hkxfile.delObj(marked_delete);
+        if (!marked_delete_subtree.empty())
+            hkxfile.delSubtree(Hkx::parseObjId(marked_delete_subtree));
 
         ImGui::EndTable();
     }
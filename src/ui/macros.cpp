@@ -109,6 +109,8 @@ void TriggerMacro::parse()
             {
                 evt                             = file->m_evt_manager.addEntry();
                 evt.get<Hkx::PropName>().text() = evt_name.c_str();
+                file->m_evt_manager.updateEntryName(evt.m_index);
+                file->markLinkedEdited();
             }
             else
                 continue;
@@ -127,6 +129,7 @@ void TriggerMacro::parse()
         trigger.getByName("relativeToEndOfClip").text()                 = time < 0 ? "true" : "false";
         trigger.getByName("event").first_child().getByName("id").text() = evt.m_index;
     }
+    file->markEdited(m_working_obj);
 }
 
 //////////////////// CRC32
@@ -175,6 +175,111 @@ void openFile()
     }
 }
 
+void openProject()
+{
+    auto        file_manager = Hkx::HkxFileManager::getSingleton();
+    nfdchar_t*  outPath      = nullptr;
+    nfdresult_t result       = NFD_PickFolder(nullptr, &outPath);
+    if (result == NFD_OKAY)
+    {
+        file_manager->loadProject(outPath);
+        free(outPath);
+    }
+    else if (result == NFD_ERROR)
+    {
+        spdlog::error("Error with file dialog:\n\t{}", NFD_GetError());
+    }
+}
+
+void showLoadingWindow()
+{
+    auto  file_manager = Hkx::HkxFileManager::getSingleton();
+    auto& jobs         = file_manager->getLoadJobs();
+
+    if (ImGui::Begin("Loading Project", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse))
+    {
+        auto finished = std::ranges::count_if(jobs, [](auto& job) { return job->state >= Hkx::HkxFileManager::kLoadDone; });
+        ImGui::ProgressBar((float)finished / jobs.size(), {-FLT_MIN, 0}, fmt::format("{}/{}", finished, jobs.size()).c_str());
+
+        for (auto& job : jobs)
+        {
+            switch (job->state.load())
+            {
+                case Hkx::HkxFileManager::kLoadQueued:
+                    ImGui::TextDisabled("Queued");
+                    break;
+                case Hkx::HkxFileManager::kLoadLoading:
+                    ImGui::TextColored({1, 1, 0, 1}, "Loading");
+                    break;
+                case Hkx::HkxFileManager::kLoadDone:
+                    ImGui::TextColored({0, 1, 0, 1}, "Done");
+                    break;
+                case Hkx::HkxFileManager::kLoadFailed:
+                    ImGui::TextColored({1, 0, 0, 1}, "Failed");
+                    break;
+            }
+            ImGui::SameLine(80);
+            ImGui::TextUnformatted(job->path.c_str());
+        }
+    }
+    ImGui::End();
+}
+
+// Delete Unreachable Objects lists them first, nothing goes w/o confirming
+Hkx::HkxFile*                            g_orphan_file = nullptr;
+std::vector<std::pair<Hkx::ObjId, bool>> g_orphans; // id, ticked for deletion
+bool                                     g_open_orphans = false;
+
+void showOrphanPopup()
+{
+    if (g_open_orphans)
+    {
+        g_open_orphans = false;
+        ImGui::OpenPopup("Delete Unreachable Objects");
+    }
+
+    bool unused_open = true;
+    if (ImGui::BeginPopupModal("Delete Unreachable Objects", &unused_open))
+    {
+        if (Hkx::HkxFileManager::getSingleton()->getCurrentFile() != g_orphan_file) // switched files in the meantime
+            ImGui::CloseCurrentPopup();
+        else
+        {
+            ImGui::TextUnformatted("The root object can't reach these. Untick the ones to keep.");
+            if (ImGui::Button("All"))
+                for (auto& [id, ticked] : g_orphans)
+                    ticked = true;
+            ImGui::SameLine();
+            if (ImGui::Button("None"))
+                for (auto& [id, ticked] : g_orphans)
+                    ticked = false;
+
+            if (ImGui::BeginListBox("##orphans", {-FLT_MIN, 20 * ImGui::GetTextLineHeightWithSpacing()}))
+            {
+                for (auto& [id, ticked] : g_orphans)
+                    ImGui::Checkbox(fmt::format("{} {}", g_orphan_file->getObjName(id), g_orphan_file->getObjClass(id)).c_str(), &ticked);
+                ImGui::EndListBox();
+            }
+
+            std::vector<Hkx::ObjId> del_ids;
+            for (auto& [id, ticked] : g_orphans)
+                if (ticked)
+                    del_ids.push_back(id);
+            ImGui::BeginDisabled(del_ids.empty());
+            if (ImGui::Button(fmt::format("Delete {} objects", del_ids.size()).c_str()))
+            {
+                g_orphan_file->delObjs(del_ids);
+                ImGui::CloseCurrentPopup();
+            }
+            ImGui::EndDisabled();
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel"))
+                ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+}
+
 void saveFileAs()
 {
     auto        file_manager = Hkx::HkxFileManager::getSingleton();
@@ -197,6 +302,7 @@ void showMenuBar()
 
     if (shortcut(ImGuiKeyModFlags_Ctrl, ImGuiKey_O)) openFile();
     if (shortcut(ImGuiKeyModFlags_Ctrl, ImGuiKey_S)) file_manager->saveFile();
+    if (shortcut(ImGuiKeyModFlags_Ctrl | ImGuiKeyModFlags_Shift, ImGuiKey_S, false)) file_manager->saveAllFiles();
     if (shortcut(ImGuiKeyModFlags_Ctrl, ImGuiKey_F4)) file_manager->closeCurrentFile();
 
     if (ImGui::BeginMainMenuBar())
@@ -207,10 +313,18 @@ void showMenuBar()
                 newFile();
             if (ImGui::MenuItem("Open", "CTRL+O"))
                 openFile();
+            if (ImGui::MenuItem("Open Project", nullptr, false, !file_manager->isLoadingProject()))
+                openProject();
             if (ImGui::MenuItem("Save", "CTRL+S", false, file_manager->isCurrentFileReady()))
                 file_manager->saveFile();
             if (ImGui::MenuItem("Save As", nullptr, false, file_manager->isCurrentFileReady()))
                 saveFileAs();
+            if (ImGui::MenuItem("Save All", "CTRL+SHIFT+S", false, !file_manager->isLoadingProject()))
+                file_manager->saveAllFiles();
+            ImGui::MenuItem("Lazy Loading", nullptr, &file_manager->m_lazy_load);
+            addTooltip("Only parse objects when they are first viewed or edited.\nFaster opening and less memory for large behaviours.");
+            ImGui::MenuItem("4-Digit Object IDs", nullptr, &file_manager->m_short_ids);
+            addTooltip("Refuse to add objects past #9999, for tools that can't read longer ids.");
 
             ImGui::Separator();
 
@@ -282,6 +396,21 @@ void showMenuBar()
                 file_manager->getCurrentFile()->buildRefList();
             if (ImGui::MenuItem("Reindex Objects", nullptr, false, file_manager->isCurrentFileReady()))
                 file_manager->getCurrentFile()->reindexObj();
+            if (ImGui::MenuItem("Delete Unreachable Objects", nullptr, false, file_manager->isCurrentFileReady()))
+            {
+                auto orphans = file_manager->getCurrentFile()->getUnreachableObjs();
+                if (orphans.empty())
+                    spdlog::info("No unreachable objects.");
+                else
+                {
+                    g_orphan_file = file_manager->getCurrentFile();
+                    g_orphans.clear();
+                    for (auto id : orphans)
+                        g_orphans.push_back({id, true});
+                    g_open_orphans = true;
+                }
+            }
+            addTooltip("List every object the root object can't reach through references, to delete them after confirming.\nThose are left behind when removing a reference and won't do anything in game.");
 
             ImGui::Separator();
 
@@ -339,6 +468,8 @@ void showDockSpace()
 
 void showMainWindow()
 {
+    Hkx::HkxFileManager::getSingleton()->update();
+
     showMenuBar();
     showDockSpace();
 
@@ -349,8 +480,10 @@ void showMainWindow()
     if (ColumnView::getSingleton()->m_show) ColumnView::getSingleton()->show();
 
     if (g_show_about) showAboutWindow();
+    if (Hkx::HkxFileManager::getSingleton()->isLoadingProject()) showLoadingWindow();
 
     MacroManager::getSingleton()->show();
+    showOrphanPopup();
 }
 } // namespace Ui
 
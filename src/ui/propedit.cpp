@@ -129,10 +129,13 @@ void PropEdit::show()
                         auto copied_obj = file.getObj(ImGui::GetClipboardText());
                         if (copied_obj && !strcmp(copied_obj.attribute("class").as_string(), class_str))
                         {
+                            file.flushNumericArrays();
+                            file.dropNumericArrays(edit_obj);
                             edit_obj.remove_children();
                             for (auto child : copied_obj.children())
                                 edit_obj.append_copy(child);
                             file.buildRefList(m_edit_obj_id);
+                            file.markEdited(edit_obj);
                         }
                         else
                             spdlog::warn("Copied object either not exist or is of different class.");
@@ -145,13 +148,13 @@ void PropEdit::show()
                         ImGui::SameLine();
                         if (ImGui::Button(ICON_FA_RECYCLE))
                         {
-                            std::string_view   def_str = def_map.at(class_str);
-                            pugi::xml_document doc;
-                            if (doc.load_buffer(def_str.data(), def_str.length()))
+                            if (auto def_obj = getXmlTemplate(def_map.at(class_str)); def_obj)
                             {
+                                file.dropNumericArrays(edit_obj);
                                 edit_obj.remove_children();
-                                for (auto child : doc.first_child().children())
+                                for (auto child : def_obj.children())
                                     edit_obj.append_copy(child);
+                                file.markEdited(edit_obj);
                             }
                             else
                                 spdlog::warn("Failed to load default value for class {}", class_str);
@@ -26,6 +26,9 @@ void VarEdit::show()
             auto file = file_manager->getCurrentFile();
             if (file->getType() == Hkx::HkxFile::kBehaviour)
             {
+                // usage counts, only objects reported changed get rescanned
+                dynamic_cast<Hkx::BehaviourFile*>(file)->updateLinkedUsage();
+
                 if (ImGui::BeginTable("varlisttbl", 2))
                 {
                     ImGui::TableNextColumn();
@@ -92,6 +95,7 @@ void VarEdit::showVarList()
                 ImGui::CloseCurrentPopup();
                 scroll_to_bottom = true;
                 file.m_var_manager.addEntry(Hkx::getVarTypeEnum(data_type));
+                file.markLinkedEdited();
                 break;
             }
         ImGui::EndPopup();
@@ -120,10 +124,11 @@ void VarEdit::showVarList()
     }
     ImGui::Separator();
 
-    if (ImGui::BeginTable("##VarList", 2, table_flag, ImVec2(-FLT_MIN, -FLT_MIN)))
+    if (ImGui::BeginTable("##VarList", 3, table_flag, ImVec2(-FLT_MIN, -FLT_MIN)))
     {
         ImGui::TableSetupColumn("id", ImGuiTableColumnFlags_WidthFixed, 36);
         ImGui::TableSetupColumn("name", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("uses", ImGuiTableColumnFlags_WidthFixed, 36);
         ImGui::TableNextRow();
 
         auto var_list = file.m_var_manager.getEntryList();
@@ -170,6 +175,13 @@ void VarEdit::showVarList()
                 addTooltip("Click to edit");
                 if (is_selected)
                     ImGui::SetItemDefaultFocus();
+
+                ImGui::TableNextColumn();
+                if (auto uses = file.getLinkedUsage(kLinkedVar, var.m_index).size(); uses)
+                    ImGui::Text("%zu", uses);
+                else
+                    ImGui::TextDisabled("0");
+                addTooltip("Times used");
             }
         varEditPopup(
             "Editing Varibale", m_var_current, file.m_var_manager, [&](size_t idx) { return file.getFirstVarRef(idx); }, file);
@@ -198,6 +210,7 @@ void VarEdit::showEvtList()
     if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
     {
         current_file.m_evt_manager.addEntry();
+        current_file.markLinkedEdited();
         scroll_to_bottom = true;
     }
     addTooltip("Add new event");
@@ -214,10 +227,11 @@ void VarEdit::showEvtList()
 
     ImGui::Separator();
 
-    if (ImGui::BeginTable("##EvtList", 2, table_flag, ImVec2(-FLT_MIN, -FLT_MIN)))
+    if (ImGui::BeginTable("##EvtList", 3, table_flag, ImVec2(-FLT_MIN, -FLT_MIN)))
     {
         ImGui::TableSetupColumn("id", ImGuiTableColumnFlags_WidthFixed, 36);
         ImGui::TableSetupColumn("name", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("uses", ImGuiTableColumnFlags_WidthFixed, 36);
         ImGui::TableNextRow();
 
         auto evt_list = current_file.m_evt_manager.getEntryList();
@@ -248,6 +262,13 @@ void VarEdit::showEvtList()
                 addTooltip("Click to edit");
                 if (is_selected)
                     ImGui::SetItemDefaultFocus();
+
+                ImGui::TableNextColumn();
+                if (auto uses = current_file.getLinkedUsage(kLinkedEvt, evt.m_index).size(); uses)
+                    ImGui::Text("%zu", uses);
+                else
+                    ImGui::TextDisabled("0");
+                addTooltip("Times used");
             }
         evtEditPopup("Editing Event", m_evt_current, current_file);
 
@@ -276,6 +297,7 @@ void VarEdit::showPropList()
     if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
     {
         current_file.m_prop_manager.addEntry();
+        current_file.markLinkedEdited();
         scroll_to_bottom = true;
     }
     addTooltip("Add new property");
@@ -292,10 +314,11 @@ void VarEdit::showPropList()
 
     ImGui::Separator();
 
-    if (ImGui::BeginTable("##PropList", 2, table_flag, ImVec2(-FLT_MIN, -FLT_MIN)))
+    if (ImGui::BeginTable("##PropList", 3, table_flag, ImVec2(-FLT_MIN, -FLT_MIN)))
     {
         ImGui::TableSetupColumn("id", ImGuiTableColumnFlags_WidthFixed, 36);
         ImGui::TableSetupColumn("name", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("uses", ImGuiTableColumnFlags_WidthFixed, 36);
         ImGui::TableNextRow();
 
         auto prop_list = current_file.m_prop_manager.getEntryList();
@@ -326,6 +349,13 @@ void VarEdit::showPropList()
                 addTooltip("Click to edit");
                 if (is_selected)
                     ImGui::SetItemDefaultFocus();
+
+                ImGui::TableNextColumn();
+                if (auto uses = current_file.getLinkedUsage(kLinkedProp, prop.m_index).size(); uses)
+                    ImGui::Text("%zu", uses);
+                else
+                    ImGui::TextDisabled("0");
+                addTooltip("Times used");
             }
         propEditPopup("Editing Property", m_prop_current, current_file);
 
@@ -360,13 +390,17 @@ void VarEdit::showCharPropList()
                 ImGui::CloseCurrentPopup();
                 scroll_to_bottom = true;
                 file.m_prop_manager.addEntry(Hkx::getVarTypeEnum(data_type));
+                file.markLinkedEdited();
                 break;
             }
         ImGui::EndPopup();
     }
     ImGui::SameLine();
     if (ImGui::Button(ICON_FA_HASHTAG))
+    {
         file.m_prop_manager.reindex();
+        file.markLinkedEdited();
+    }
     addTooltip("Reindex properties\nDiscard all properties marked obsolete");
 
     ImGui::InputText("Filter", &m_charprop_filter), ImGui::SameLine();
@@ -463,6 +497,7 @@ void VarEdit::showAnimList()
     if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
     {
         appendXmlString(anim_node, Hkx::g_def_hkStringPtr);
+        file.markEdited(anim_node);
         scroll_to_bottom = true;
     }
     addTooltip("Add new animation");
@@ -488,6 +523,7 @@ void VarEdit::showAnimList()
                 if (ImGui::InputText("##name", &name, ImGuiInputTextFlags_EnterReturnsTrue))
                 {
                     anim_nodes[row_n].text() = name.c_str();
+                    file.markEdited(anim_node);
                     if (name.empty())
                         mark_delete = anim_nodes[row_n];
                 }
@@ -20,17 +20,9 @@ std::optional<pugi::xml_node> statePickerPopup(const char* str_id, pugi::xml_nod
 {
     if (ImGui::IsPopupOpen(str_id))
     {
-        auto                        states_node = state_machine.getByName("states");
-        size_t                      num_objs    = states_node.attribute("numelements").as_ullong();
-        std::istringstream          states_stream(states_node.text().as_string());
-        std::vector<pugi::xml_node> states(num_objs);
-
-        for (size_t i = 0; i < num_objs; ++i)
-        {
-            std::string temp_str;
-            states_stream >> temp_str;
-            states[i] = file.getObj(temp_str);
-        }
+        std::vector<pugi::xml_node> states;
+        for (auto [state_id, id] : file.getStateIds(Hkx::parseObjId(state_machine.attribute("name").as_string())).states)
+            states.push_back(file.getObj(id));
 
         return pickerPopup<pugi::xml_node>(
             str_id, states,
@@ -238,6 +230,8 @@ void varBindingButton(const char* str_id, pugi::xml_node hkparam, Hkx::Behaviour
             }
             if ((param_path == "enable") && std::string_view(parent.attribute("class").as_string()).contains("Modifier"))
                 bindings.parent().getByName("indexOfBindingToEnable").text() = getChildIndex(prev_binding);
+            file->markEdited(parent);
+            file->markEdited(bindings);
         }
     }
     ImGui::PopID();
@@ -258,10 +252,11 @@ bool BoolEdit::showEdit() { return ImGui::Checkbox(getName(), &m_value); }
 
 void QuadEdit::fetchValue()
 {
-    std::string text(m_hkparam.text().as_string());
-    std::erase_if(text, [](char& c) { return (c == '(') || (c == ')'); });
-    std::istringstream text_stream(text);
-    text_stream >> m_value[0] >> m_value[1] >> m_value[2] >> m_value[3];
+    size_t i = 0;
+    forEachToken(m_hkparam.text().as_string(), [&](std::string_view token) {
+        parseToken(token, m_value[i]);
+        return ++i < 4;
+    });
 }
 void QuadEdit::updateValue() { m_hkparam.text() = fmt::format("({:.6f} {:.6f} {:.6f} {:.6f})", m_value[0], m_value[1], m_value[2], m_value[3]).c_str(); }
 bool QuadEdit::showEdit() { return ImGui::InputFloat4(getName(), m_value, "%.6f"); }
@@ -386,14 +381,15 @@ bool refEdit(std::string&                         value,
 
     if (edited)
     {
-        auto parent_id = parent.attribute("name").as_string();
-        if (!isRefBy(old_value, parent))
-            file.deRef(old_value, parent_id);
-        file.addRef(value, parent_id);
+        file.replaceRef(parent.attribute("name").as_string(), old_value, value);
         // for states
         if (auto obj = file.getObj(value); !strcmp(obj.attribute("class").as_string(), "hkbStateMachineStateInfo"))
             if (auto state_machine = getParentStateMachine(obj, file); state_machine.getByName("states").attribute("numelements").as_uint() > 1)
+            {
                 obj.getByName("stateId").text() = getBiggestStateId(state_machine, file) + 1;
+                file.invalidateStateIds();
+                file.markEdited(obj);
+            }
     }
 
     ImGui::PopID();
@@ -411,13 +407,8 @@ void refList(pugi::xml_node                       hkparam,
     auto                     parent   = getParentObj(hkparam);
     std::vector<std::string> objs     = {};
     size_t                   num_objs = hkparam.attribute("numelements").as_ullong();
-    std::istringstream       states_stream(hkparam.text().as_string());
-    for (size_t i = 0; i < num_objs; ++i)
-    {
-        std::string temp_str;
-        states_stream >> temp_str;
-        objs.push_back(temp_str);
-    }
+    parsePayload(hkparam.text().as_string(), objs, num_objs);
+    objs.resize(num_objs);
 
     ImGui::AlignTextToFramePadding();
     ImGui::TextUnformatted(manual_name.empty() ? hkparam.attribute("name").as_string() : manual_name.data()), ImGui::SameLine();
@@ -450,10 +441,17 @@ void refList(pugi::xml_node                       hkparam,
             ImGui::PopID();
         }
         if (do_delete)
+        {
+            file.deRef(objs[mark_delete], parent.attribute("name").as_string());
             objs.erase(objs.begin() + mark_delete);
+        }
 
-        hkparam.text()                   = printVector(objs).c_str();
-        hkparam.attribute("numelements") = objs.size();
+        if (auto text = printVector(objs); text != hkparam.text().as_string())
+        {
+            hkparam.text()                   = text.c_str();
+            hkparam.attribute("numelements") = objs.size();
+            file.markEdited(hkparam);
+        }
 
         ImGui::EndTable();
     }
@@ -470,13 +468,8 @@ pugi::xml_node refLiveEditList(
     auto                     parent   = getParentObj(hkparam);
     std::vector<std::string> objs     = {};
     size_t                   num_objs = hkparam.attribute("numelements").as_ullong();
-    std::istringstream       states_stream(hkparam.text().as_string());
-    for (size_t i = 0; i < num_objs; ++i)
-    {
-        std::string temp_str;
-        states_stream >> temp_str;
-        objs.push_back(temp_str);
-    }
+    parsePayload(hkparam.text().as_string(), objs, num_objs);
+    objs.resize(num_objs);
 
     ImGui::AlignTextToFramePadding();
     ImGui::TextUnformatted(manual_name.empty() ? hkparam.attribute("name").as_string() : manual_name.data()), ImGui::SameLine();
@@ -524,11 +517,16 @@ pugi::xml_node refLiveEditList(
         }
         if (do_delete)
         {
+            file.deRef(objs[mark_delete], parent.attribute("name").as_string());
             objs.erase(objs.begin() + mark_delete);
             hkparam.attribute("numelements") = hkparam.attribute("numelements").as_int() - 1;
         }
 
-        hkparam.text() = printVector(objs).c_str();
+        if (auto text = printVector(objs); text != hkparam.text().as_string())
+        {
+            hkparam.text() = text.c_str();
+            file.markEdited(hkparam);
+        }
 
         ImGui::EndTable();
     }
@@ -545,15 +543,22 @@ void objLiveEditList(
     ImGui::AlignTextToFramePadding();
     ImGui::BulletText(str_id.data()), ImGui::SameLine();
     if (ImGui::Button(ICON_FA_PLUS_CIRCLE))
+    {
         appendXmlString(hkparam, def_str);
+        Hkx::HkxFileManager::getSingleton()->markEdited(hkparam);
+    }
     addTooltip("Add new item");
     ImGui::SameLine();
     if (ImGui::Button(ICON_FA_MINUS_CIRCLE) && edit_item)
+    {
+        Hkx::HkxFileManager::getSingleton()->getCurrentFile()->deRefNode(edit_item); // payloads etc.
         if (hkparam.remove_child(edit_item))
         {
             edit_item                        = {};
             hkparam.attribute("numelements") = hkparam.attribute("numelements").as_int() - 1;
+            Hkx::HkxFileManager::getSingleton()->markEdited(hkparam);
         }
+    }
     addTooltip("Remove currently editing item.");
     ImGui::SameLine();
     ImGui::AlignTextToFramePadding();
@@ -577,6 +582,24 @@ void objLiveEditList(
 
 ////////////////    Linked Prop Edits
 
+// every object using the index, click to go there
+// hkparam isn't touched, the list may be a moment behind edits that removed it
+static void linkedUsageList(Hkx::BehaviourFile& file, LinkedNodeType type, size_t idx)
+{
+    auto usage = file.getLinkedUsage(type, idx);
+    if (!ImGui::CollapsingHeader(fmt::format("Used {} time(s)###usage", usage.size()).c_str()) || usage.empty())
+        return;
+
+    if (ImGui::BeginChild("usage", ImVec2(0, std::min(usage.size(), size_t(8)) * ImGui::GetTextLineHeightWithSpacing())))
+        for (size_t i = 0; i < usage.size(); ++i)
+        {
+            auto obj_name = file.getObjName(usage[i].obj);
+            if (ImGui::Selectable(fmt::format("{} {}##{}", obj_name, file.getObj(usage[i].obj).getByName("name").text().as_string(), i).c_str()))
+                setPropObj(obj_name);
+        }
+    ImGui::EndChild();
+}
+
 void varEditPopup(const char*                           str_id,
                   Hkx::Variable&                        var,
                   Hkx::VariableManager&                 manager,
@@ -588,6 +611,7 @@ void varEditPopup(const char*                           str_id,
         if (ImGui::BeginTable("varedit", 2, ImGuiTableFlags_SizingStretchProp, ImVec2(600, -FLT_MIN)))
         {
             StringEdit(var.get<Hkx::PropName>()).name("name")();
+            manager.updateEntryName(var.m_index);
             ImGui::SameLine();
             if (ImGui::Button(ICON_FA_TRASH))
             {
@@ -659,6 +683,8 @@ void varEditPopup(const char*                           str_id,
 
             ImGui::EndTable();
         }
+        if (file.getType() == Hkx::HkxFile::kBehaviour)
+            linkedUsageList(dynamic_cast<Hkx::BehaviourFile&>(file), kLinkedVar, var.m_index);
         ImGui::EndPopup();
     }
 }
@@ -670,6 +696,7 @@ void evtEditPopup(const char* str_id, Hkx::AnimationEvent& evt, Hkx::BehaviourFi
         if (ImGui::BeginTable("eventedit", 2, ImGuiTableFlags_SizingStretchProp, ImVec2(300.0, 0.0)))
         {
             StringEdit(evt.get<Hkx::PropName>()).name("name")();
+            file.m_evt_manager.updateEntryName(evt.m_index);
             ImGui::SameLine();
             if (ImGui::Button(ICON_FA_TRASH))
             {
@@ -696,6 +723,7 @@ void evtEditPopup(const char* str_id, Hkx::AnimationEvent& evt, Hkx::BehaviourFi
 
             ImGui::EndTable();
         }
+        linkedUsageList(file, kLinkedEvt, evt.m_index);
         ImGui::EndPopup();
     }
 }
@@ -707,11 +735,12 @@ void propEditPopup(const char* str_id, Hkx::CharacterProperty& prop, Hkx::Behavi
         if (ImGui::BeginTable("eventedit", 2, ImGuiTableFlags_SizingStretchProp, ImVec2(300.0, 0.0)))
         {
             StringEdit(prop.get<Hkx::PropName>()).name("name")();
+            file.m_prop_manager.updateEntryName(prop.m_index);
             ImGui::SameLine();
             if (ImGui::Button(ICON_FA_TRASH))
             {
                 auto name     = prop.get<Hkx::PropName>().text().as_string();
-                auto ref_node = file.getFirstEventRef(prop.m_index);
+                auto ref_node = file.getFirstPropRef(prop.m_index);
                 if (ref_node)
                 {
                     spdlog::warn("This property is still referenced by {} and potentially more object.\nID copied to clipboard.", ref_node.attribute("name").as_string());
@@ -719,8 +748,8 @@ void propEditPopup(const char* str_id, Hkx::CharacterProperty& prop, Hkx::Behavi
                 }
                 else
                 {
-                    file.m_evt_manager.delEntry(prop.m_index);
-                    spdlog::info("Event {} deleted!", name);
+                    file.m_prop_manager.delEntry(prop.m_index);
+                    spdlog::info("Property {} deleted!", name);
                     ImGui::EndTable();
                     ImGui::CloseCurrentPopup();
                     ImGui::EndPopup();
@@ -736,6 +765,7 @@ void propEditPopup(const char* str_id, Hkx::CharacterProperty& prop, Hkx::Behavi
 
             ImGui::EndTable();
         }
+        linkedUsageList(file, kLinkedProp, prop.m_index);
         ImGui::EndPopup();
     }
 }
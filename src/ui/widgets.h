@@ -308,7 +308,10 @@ struct ParamEdit
         update |= showButton();
 
         if (update)
+        {
             updateValue();
+            Hkx::HkxFileManager::getSingleton()->markEdited(m_hkparam);
+        }
     }
     virtual bool showEdit() = 0;    // edit internal value, return true if value edited
     virtual bool showButton();      // return true if value edited
@@ -566,16 +569,13 @@ struct RefEdit : public StringEdit
     }
     virtual void updateValue() override
     {
-        auto old_value  = m_hkparam.text().as_string();
-        auto parent_obj = getParentObj(m_hkparam);
+        std::string old_value  = m_hkparam.text().as_string();
+        auto        parent_obj = getParentObj(m_hkparam);
         assert(parent_obj);
-        auto parent_id = parent_obj.attribute("name").as_string();
 
         StringEdit::updateValue();
 
-        if (!isRefBy(old_value, parent_obj))
-            m_file->deRef(old_value, parent_id);
-        m_file->addRef(m_value, parent_id);
+        m_file->replaceRef(parent_obj.attribute("name").as_string(), old_value, m_value);
     }
     DEF_EDIT_CONSTR(RefEdit, StringEdit)
 };
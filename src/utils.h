@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <charconv>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <functional>
 #include <mutex>
@@ -119,6 +123,29 @@ template <typename T>
 using StringMap = robin_hood::unordered_map<std::string, T, StringHash, std::equal_to<>>;
 using StringSet = robin_hood::unordered_set<std::string, StringHash, std::equal_to<>>;
 
+// same but ignoring ascii case, like _stricmp
+struct StringHashNoCase
+{
+    using is_transparent = void;
+    [[nodiscard]] size_t operator()(std::string_view txt) const
+    {
+        size_t hash = 0xcbf29ce484222325; // fnv-1a
+        for (auto ch : txt)
+            hash = (hash ^ (uint8_t)std::tolower((uint8_t)ch)) * 0x100000001b3;
+        return hash;
+    }
+};
+struct StringEqualNoCase
+{
+    using is_transparent = void;
+    [[nodiscard]] bool operator()(std::string_view lhs, std::string_view rhs) const
+    {
+        return std::ranges::equal(lhs, rhs, [](char ch1, char ch2) { return std::tolower((uint8_t)ch1) == std::tolower((uint8_t)ch2); });
+    }
+};
+template <typename T>
+using StringMapNoCase = robin_hood::unordered_map<std::string, T, StringHashNoCase, StringEqualNoCase>;
+
 // crc32
 // source: https://gist.github.com/timepp/1f678e200d9e0f2a043a9ec6b3690635
 // actually it's nemesis
@@ -193,25 +220,42 @@ struct Crc32
     }
 
 //////////////////////////    XML HELPERS
+// parsed template nodes (g_def_xxx etc.), each string only gets parsed once
+// templates live till exit and are never modified, so copying from them is fine
+inline pugi::xml_node getXmlTemplate(std::string_view srcString)
+{
+    static pugi::xml_document        template_doc;
+    static StringMap<pugi::xml_node> templates;
+    static std::mutex                template_mutex;
+
+    std::lock_guard lock(template_mutex);
+    if (auto it = templates.find(srcString); it != templates.end())
+        return it->second;
+
+    auto last_child = template_doc.last_child();
+    if (!template_doc.append_buffer(srcString.data(), srcString.length(), pugi::parse_default & (~pugi::parse_escapes)))
+    {
+        // drop whatever got appended before the error
+        while (template_doc.last_child() != last_child)
+            template_doc.remove_child(template_doc.last_child());
+        return {};
+    }
+    return templates[std::string(srcString)] = last_child ? last_child.next_sibling() : template_doc.first_child();
+}
+
 inline pugi::xml_node appendXmlString(pugi::xml_node target, std::string_view srcString)
 {
-    // parse XML string as document
-    pugi::xml_document doc;
-    if (!doc.load_buffer(srcString.data(), srcString.length(), pugi::parse_default & (~pugi::parse_escapes)))
+    auto src = getXmlTemplate(srcString);
+    if (!src)
         return {};
 
     if (target.attribute("numelements"))
         target.attribute("numelements") = target.attribute("numelements").as_uint() + 1;
-    return target.append_copy(doc.first_child());
+    return target.append_copy(src);
 }
 
 #define getByName(name) find_child_by_attribute("name", name)
 
-inline bool isRefBy(std::string_view id, pugi::xml_node obj)
-{
-    return obj.find_node([=](pugi::xml_node node) { return (node.type() == pugi::node_pcdata) && std::string_view(node.value()).contains(id); });
-}
-
 inline pugi::xml_node getParentObj(pugi::xml_node node)
 {
     for (auto iter = node; iter; iter = iter.parent())
@@ -236,18 +280,79 @@ inline std::string hkobj2str(pugi::xml_node obj)
     return fmt::format("{} [{}] - {}", obj.attribute("name").as_string(), getObjContextName(obj), obj.attribute("class").as_string());
 }
 
+// hkx text payloads: lists of numbers, ids, bools and (x y z w) tuples
+// whitespace, commas and parentheses all separate, no allocation per token unlike istringstream
+constexpr bool isPayloadSeparator(char ch)
+{
+    return (ch == ' ') || (ch == '\n') || (ch == '\r') || (ch == '\t') || (ch == ',') || (ch == '(') || (ch == ')');
+}
+
+// func(token) returns whether to go on
+template <typename Func>
+inline void forEachToken(std::string_view text, Func&& func)
+{
+    size_t pos = 0;
+    while (true)
+    {
+        while ((pos < text.size()) && isPayloadSeparator(text[pos]))
+            ++pos;
+        if (pos == text.size())
+            return;
+        auto end = pos;
+        while ((end < text.size()) && !isPayloadSeparator(text[end]))
+            ++end;
+        if (!func(text.substr(pos, end - pos)))
+            return;
+        pos = end;
+    }
+}
+
+// out is left alone if the token isn't a T
+template <typename T>
+inline bool parseToken(std::string_view token, T& out)
+{
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        out = (token == "true");
+        return out || (token == "false");
+    }
+    else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+    {
+        out = token;
+        return true;
+    }
+    else
+        return std::from_chars(token.data(), token.data() + token.size(), out).ec == std::errc();
+}
+
+// append up to max tokens of text to out, bad ones as T{}
+template <typename T>
+inline void parsePayload(std::string_view text, std::vector<T>& out, size_t max = SIZE_MAX)
+{
+    if (!max)
+        return;
+    forEachToken(text, [&](std::string_view token) {
+        T value = {}; // not emplace_back, vector<bool>
+        parseToken(token, value);
+        out.push_back(std::move(value));
+        return --max > 0;
+    });
+}
+
 template <typename T>
 inline std::string printVector(const std::vector<T>& vec)
 {
-    std::string retval = {};
+    fmt::memory_buffer buffer;
     for (size_t i = 0; i < vec.size(); ++i)
     {
         if constexpr (std::is_same_v<T, float>)
-            retval.append(fmt::format("{:.6f} {}", vec[i], ((i + 1) % 10) ? "" : "\n"));
+            fmt::format_to(std::back_inserter(buffer), "{:.6f} ", vec[i]);
         else
-            retval.append(fmt::format("{} {}", vec[i], ((i + 1) % 10) ? "" : "\n"));
+            fmt::format_to(std::back_inserter(buffer), "{} ", vec[i]);
+        if (!((i + 1) % 10))
+            buffer.push_back('\n');
     }
-    return retval;
+    return fmt::to_string(buffer);
 }
 
 inline uint32_t getChildIndex(pugi::xml_node hkobject)
@@ -286,43 +391,111 @@ inline pugi::xml_node getNthChild(pugi::xml_node node, size_t n)
     return retval;
 }
 
-inline bool isVarNode(pugi::xml_node node)
+// which linked property a node holds the index of
+enum LinkedNodeType
 {
-    auto var_name = node.attribute("name").as_string();
-    return (!strcmp(var_name, "variableIndex") && !strcmp(node.parent().getByName("bindingType").text().as_string(), "BINDING_TYPE_VARIABLE")) ||
-        !strcmp(var_name, "syncVariableIndex") ||     // hkbStateMachine
-        !strcmp(var_name, "assignmentVariableIndex"); // hkbExpressionData
-}
+    kLinkedNone,
+    kLinkedVar,
+    kLinkedEvt,
+    kLinkedProp
+};
 
-inline bool isEvtNode(pugi::xml_node node)
+// perfect hash over a fixed set of strings, seed and table found at compile time
+// one hash and one compare per lookup
+template <size_t N, size_t TableSize = std::bit_ceil(N) * 2>
+class StaticStringSet
 {
-    auto node_name = node.attribute("name").as_string();
-
-    auto parentparent = node.parent().parent();
-    auto pp_name      = parentparent.attribute("name").as_string();
-    bool is_hkbEvent =
-        !strcmp(pp_name, "event") ||
-        !strcmp(pp_name, "events") ||
-        !strcmp(pp_name, "triggerEvent") ||                            // BSDistTriggerModifier & BSPassByTargetTriggerModifier
-        !strcmp(pp_name, "contactEvent") ||                            // BSRagdollContactListenerModifier
-        !strcmp(pp_name, "eventToSendWhenStateOrTransitionChanges") || // hkbStateMachine
-        !strcmp(pp_name, "EventToFreezeBlendValue") ||                 // BSCyclicBlendTransitionGenerator
-        !strcmp(pp_name, "EventToCrossBlend") ||
-        !strcmp(pp_name, "alarmEvent") ||    // hkbTimerModifier & BSTimerModifier
-        !strcmp(pp_name, "ungroundedEvent"); // hkbFootIkControlsModifier
-
-    return !strcmp(node_name, "eventId") ||   // hkbStateMachineTransitionInfo
-        !strcmp(node_name, "enterEventId") || // hkbStateMachineStateInfo/TimeInterval
-        !strcmp(node_name, "exitEventId") ||
-        !strcmp(node_name, "assignmentEventIndex") ||         // hkbExpressionData
-        !strcmp(node_name, "returnToPreviousStateEventId") || // hkbStateMachine
-        !strcmp(node_name, "randomTransitionEventId") ||
-        !strcmp(node_name, "transitionToNextHigherStateEventId") ||
-        !strcmp(node_name, "transitionToNextLowerStateEventId") ||
-        (!strcmp(node_name, "id") && is_hkbEvent);
-}
+public:
+    consteval StaticStringSet(const std::array<std::string_view, N>& strs) :
+        m_strs(strs)
+    {
+        for (m_seed = 0;; ++m_seed)
+        {
+            m_slots.fill(N);
+            bool collided = false;
+            for (size_t i = 0; (i < N) && !collided; ++i)
+            {
+                auto& slot = m_slots[hash(m_strs[i], m_seed)];
+                collided   = (slot != N);
+                slot       = i;
+            }
+            if (!collided)
+                break;
+        }
+    }
+
+    // index in strs, N if not in it
+    constexpr size_t find(std::string_view str) const
+    {
+        auto idx = m_slots[hash(str, m_seed)];
+        return ((idx != N) && (m_strs[idx] == str)) ? idx : N;
+    }
+
+private:
+    std::array<std::string_view, N> m_strs;
+    std::array<size_t, TableSize>   m_slots = {};
+    uint32_t                        m_seed  = 0;
+
+    static constexpr size_t hash(std::string_view str, uint32_t seed)
+    {
+        uint32_t hash = 2166136261u ^ seed; // fnv-1a
+        for (auto ch : str)
+            hash = (hash ^ (uint8_t)ch) * 16777619u;
+        return hash & (TableSize - 1);
+    }
+};
 
-inline bool isPropNode(pugi::xml_node node)
+// hkparam names holding a linked index, one lookup for all three kinds
+// the first two depend on where they are, see getLinkedNodeType
+inline constexpr StaticStringSet<12> g_linked_param_names = std::array<std::string_view, 12>{
+    "variableIndex",                // hkbVariableBindingSet, var or prop by bindingType
+    "id",                           // hkbEventProperty, only under the params below
+    "syncVariableIndex",            // hkbStateMachine
+    "assignmentVariableIndex",      // hkbExpressionData
+    "eventId",                      // hkbStateMachineTransitionInfo
+    "enterEventId",                 // hkbStateMachineStateInfo/TimeInterval
+    "exitEventId",
+    "assignmentEventIndex",         // hkbExpressionData
+    "returnToPreviousStateEventId", // hkbStateMachine
+    "randomTransitionEventId",
+    "transitionToNextHigherStateEventId",
+    "transitionToNextLowerStateEventId"};
+inline constexpr std::array<LinkedNodeType, 12> g_linked_param_types = {
+    kLinkedNone, kLinkedNone,
+    kLinkedVar, kLinkedVar,
+    kLinkedEvt, kLinkedEvt, kLinkedEvt, kLinkedEvt, kLinkedEvt, kLinkedEvt, kLinkedEvt, kLinkedEvt};
+// hkparams an "id" has to be in (as grandparent) to be an event
+inline constexpr StaticStringSet<9> g_event_param_names = std::array<std::string_view, 9>{
+    "event",
+    "events",
+    "triggerEvent",                            // BSDistTriggerModifier & BSPassByTargetTriggerModifier
+    "contactEvent",                            // BSRagdollContactListenerModifier
+    "eventToSendWhenStateOrTransitionChanges", // hkbStateMachine
+    "EventToFreezeBlendValue",                 // BSCyclicBlendTransitionGenerator
+    "EventToCrossBlend",
+    "alarmEvent",       // hkbTimerModifier & BSTimerModifier
+    "ungroundedEvent"}; // hkbFootIkControlsModifier
+
+inline LinkedNodeType getLinkedNodeType(pugi::xml_node node)
 {
-    return (!strcmp(node.attribute("name").as_string(), "variableIndex") && !strcmp(node.parent().getByName("bindingType").text().as_string(), "BINDING_TYPE_CHARACTER_PROPERTY"));
-}
\ No newline at end of file
+    switch (auto idx = g_linked_param_names.find(node.attribute("name").as_string()))
+    {
+        case 0:
+        {
+            std::string_view binding_type = node.parent().getByName("bindingType").text().as_string();
+            if (binding_type == "BINDING_TYPE_VARIABLE")
+                return kLinkedVar;
+            if (binding_type == "BINDING_TYPE_CHARACTER_PROPERTY")
+                return kLinkedProp;
+            return kLinkedNone;
+        }
+        case 1:
+            return (g_event_param_names.find(node.parent().parent().attribute("name").as_string()) < 9) ? kLinkedEvt : kLinkedNone;
+        default:
+            return (idx < g_linked_param_types.size()) ? g_linked_param_types[idx] : kLinkedNone;
+    }
+}
+
+inline bool isVarNode(pugi::xml_node node) { return getLinkedNodeType(node) == kLinkedVar; }
+inline bool isEvtNode(pugi::xml_node node) { return getLinkedNodeType(node) == kLinkedEvt; }
+inline bool isPropNode(pugi::xml_node node) { return getLinkedNodeType(node) == kLinkedProp; }
\ No newline at end of file